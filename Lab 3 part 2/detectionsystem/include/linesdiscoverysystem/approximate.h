@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <linesdiscoverysystem/gridpoint.h>
+#include <linesdiscoverysystem/readfiles.h>
+
+/*
+ * Settings of the approximate line search
+ */
+struct ApproximateOptions {
+    std::size_t minPoints = 4;        // only lines with at least this many (and at least 4) points are searched for
+    double failureProbability = 0.01; // upper bound for missing any single such line
+    std::uint64_t seed = 2024;        // seed of the pair sampling, the same seed gives the same result
+};
+
+/*
+ * Finds the lines through minPoints or more of the given points with high probability
+ * Instead of grouping the points around every point, every pair of points is sampled with probability r and votes
+ * for the line through it. A line of m points gets Binomial(m(m-1)/2, r) votes, r is the smallest rate for which a
+ * line of minPoints points gets fewer than two votes with probability at most failureProbability, about
+ * 2 (ln(1/failureProbability) + 2) / minPoints^2. A line through two random points gets one vote, so the lines with two or
+ * more votes are the candidates, and every candidate is checked against all points.
+ * Time complexity: O(r n^2 log n + c n) for c candidates, i.e. O(n^2/minPoints^2 * log(1/failureProbability) log n),
+ * near-linear once minPoints grows like sqrt(n). When r would exceed 1/4, findLines does less work and is used.
+ * Every reported line is exact and complete, lines are ordered like findLines.
+ */
+std::vector<Line> findLinesApproximate(const std::vector<GridPoint>& points, const ApproximateOptions& options,
+                                       unsigned threads = 0);
+
+/*
+ * Fraction of the lines in exact with at least minPoints points that are also in found, 1 if there are none
+ */
+double lineRecall(const std::vector<Line>& exact, const std::vector<Line>& found, std::size_t minPoints);
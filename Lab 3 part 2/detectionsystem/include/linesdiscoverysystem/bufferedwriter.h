@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <ostream>
+
+#include <fmt/format.h>
+
+/*
+ * Formats text straight into a reusable in-memory buffer and hands it to the stream in large chunks
+ * Nothing is flushed per line, the buffer is written when it grows past its capacity, on flush()
+ * and when the writer is destroyed
+ */
+class BufferedWriter {
+public:
+    static constexpr std::size_t defaultCapacity = 1 << 20;
+
+    explicit BufferedWriter(std::ostream& os, std::size_t theCapacity = defaultCapacity)
+        : out{os}, capacity{theCapacity} {
+        buffer.reserve(capacity + capacity / 8);
+    }
+
+    // Disallow copying
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    ~BufferedWriter() { flush(); }
+
+    // Append formatted text, see fmt::format for the syntax
+    template <typename... Args>
+    void print(fmt::format_string<Args...> format, Args&&... args) {
+        fmt::format_to(std::back_inserter(buffer), format, std::forward<Args>(args)...);
+        if (buffer.size() >= capacity) flush();
+    }
+
+    // Write everything buffered so far to the stream
+    void flush() {
+        if (buffer.size() == 0) return;
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        out.flush();
+        buffer.clear();
+    }
+
+private:
+    std::ostream& out;
+    std::size_t capacity;
+    fmt::memory_buffer buffer;
+};
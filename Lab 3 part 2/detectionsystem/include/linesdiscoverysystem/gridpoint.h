@@ -0,0 +1,16 @@
+#pragma once
+
+#include <compare>
+#include <cstdint>
+
+/*
+ * Point of the line discovery, with the integer coordinates of the points files, normally in [0, 32767]
+ * 8 bytes instead of the 36 bytes of a rendering::Point, and exact to compare and subtract.
+ * Ordered by x and then by y.
+ */
+struct GridPoint {
+    std::int32_t x{0};
+    std::int32_t y{0};
+
+    auto operator<=>(const GridPoint&) const = default;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+#include <vector>
+
+#include <linesdiscoverysystem/gridpoint.h>
+#include <linesdiscoverysystem/readfiles.h>
+#include <linesdiscoverysystem/slopetable.h>
+
+/*
+ * Line discovery for a point set that grows over time
+ * The discovered lines are kept in an index keyed on the exact line through them. Adding a point only
+ * groups the points already present by their direction from the new point: lines that gain the point are
+ * extended in place and lines that reach four points are created, nothing is rediscovered.
+ * Adding k points to n costs O(k*n) expected time.
+ */
+class IncrementalLineDetector {
+public:
+    // -- CONSTRUCTORS
+    IncrementalLineDetector() = default;
+
+    // Start from the given points, the initial search uses findLines
+    explicit IncrementalLineDetector(std::vector<GridPoint> points, unsigned threads = 0);
+
+    // -- MEMBER FUNCTIONS
+
+    // Add points and update the discovered lines
+    void addPoints(const std::vector<GridPoint>& newPoints);
+
+    // All points added so far, line point indices refer to this vector
+    const std::vector<GridPoint>& points() const { return pointVector; }
+
+    // The discovered lines, in the same order as findLines would return them
+    std::vector<Line> lines() const;
+
+    // Store the points and the line index to file, so that a later run can continue from it
+    void save(const std::filesystem::path& file) const;
+
+    // Continue from a file written by save(), throws std::runtime_error if the file can not be read
+    static IncrementalLineDetector load(const std::filesystem::path& file);
+
+private:
+    LineKey keyOf(const Direction& direction, std::uint32_t point) const;
+    LineKey keyOf(const Line& line) const;
+
+    // Add a single point, all points before it are already indexed
+    void addPoint(std::uint32_t point);
+
+    // -- DATA MEMBERS
+    std::vector<GridPoint> pointVector;
+    std::vector<Line> lineVector;                           // points of each line, sorted by x and then y
+    std::unordered_map<LineKey, std::uint32_t, LineKeyHash> index;  // line -> position in lineVector
+    SlopeTable table;                                       // reused for every added point
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/*
+ * Number of worker threads used for a requested thread count
+ * 0 means one worker per hardware thread
+ */
+inline unsigned workerCount(unsigned threads) {
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    return std::max(threads, 1u);
+}
+
+/*
+ * Calls body(i, worker) for every i in [0, count) on a pool of workerCount(threads) threads
+ * Indices are handed out in small chunks from a shared counter, so that workers finishing early
+ * take over the remaining work. worker is in [0, workerCount(threads)) and can be used to index
+ * per-thread buffers. With a single worker everything runs on the calling thread.
+ */
+template <typename F>
+void parallelFor(std::size_t count, unsigned threads, F&& body) {
+    const unsigned workers = static_cast<unsigned>(std::min<std::size_t>(workerCount(threads), std::max<std::size_t>(count, 1)));
+
+    if (workers == 1) {
+        for (std::size_t i = 0; i < count; ++i) body(i, 0u);
+        return;
+    }
+
+    // Small enough to balance the load, large enough to keep the counter from being contended
+    const std::size_t chunk = std::clamp<std::size_t>(count / (workers * 16), 1, 64);
+    std::atomic<std::size_t> next{0};
+
+    auto work = [&](unsigned worker) {
+        for (;;) {
+            const std::size_t first = next.fetch_add(chunk, std::memory_order_relaxed);
+            if (first >= count) return;
+            const std::size_t last = std::min(first + chunk, count);
+            for (std::size_t i = first; i < last; ++i) body(i, worker);
+        }
+    };
+
+    {
+        std::vector<std::jthread> pool;
+        pool.reserve(workers - 1);
+        for (unsigned worker = 1; worker < workers; ++worker) pool.emplace_back(work, worker);
+        work(0u);
+    }  // joins the pool
+}
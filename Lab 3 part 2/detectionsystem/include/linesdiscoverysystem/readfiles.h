@@ -2,9 +2,12 @@
 
 #include <iostream>
 #include <vector>
+#include <string>
+#include <cstdint>
 #include <filesystem>
 
 #include <rendering/window.h>
+#include <linesdiscoverysystem/gridpoint.h>
 
 #include <fmt/format.h>
 
@@ -20,10 +23,67 @@ std::vector<rendering::Point> readLineSegments(const std::filesystem::path& file
 
 /*
 * Reads all points from a given input file -- see folder detectionsystem\data
-* Returns a vector of points that can be rendered
+* Returns a vector with the integer coordinates of the points
+*/
+std::vector<GridPoint> readPoints(const std::filesystem::path& file);
+
+/*
+* Converts points to a vector of points that can be rendered
+*/
+std::vector<rendering::Point> renderPoints(const std::vector<GridPoint>& points);
+
+/*
+* A discovered line: the indices of its points, sorted by x and then by y
+*/
+using Line = std::vector<std::uint32_t>;
+
+/*
+* Time spent in the phases of findLines, in milliseconds
+* grouping_ms is summed over all threads
+*/
+struct DetectionTimings {
+    double sort_ms{0.0};      // sorting the points and the discovered lines
+    double grouping_ms{0.0};  // bucketing all pairs of points by their direction and collecting the lines
+};
+
+/*
+* Finds all lines through four or more of the given points
+* Lines are sorted by slope and then by intercept, each line is reported once
+* The work is split over the given number of threads, 0 uses all hardware threads
+* If timings is not null, the time spent in each phase is stored in it
 */
-std::vector<rendering::Point> readPoints(const std::filesystem::path& file);
+std::vector<Line> findLines(const std::vector<GridPoint>& points, unsigned threads = 0,
+                            DetectionTimings* timings = nullptr);
 
+/*
+* Sorts lines by slope and then by intercept, the order findLines returns them in
+*/
+void sortLines(std::vector<Line>& lines, const std::vector<GridPoint>& points);
 
-void writeLines(std::vector<rendering::Point> pointVector, std::string pointPath);
-void writeFile(std::vector<std::string> lines, std::string path);
\ No newline at end of file
+/*
+* Returns the line segments of the given lines as a vector of points that can be rendered
+* Two points per segment: the first and the last point of the line
+*/
+std::vector<rendering::Point> lineSegments(const std::vector<Line>& lines, const std::vector<GridPoint>& points);
+
+/*
+* Returns the file the segments discovered in the points file pointsName are written to: <outputDir>/segments-<pointsName>
+*/
+std::filesystem::path segmentsFile(const std::string& pointsName, const std::filesystem::path& outputDir = data_dir / "output");
+
+/*
+* Finds all lines among the points and writes their line segments to outputFile
+* The points of every line are also printed to the console if echo is set
+* Returns the line segments, so that they can be rendered without reading outputFile back
+* throws std::runtime_error if outputFile can not be written
+*/
+std::vector<rendering::Point> writeLines(const std::vector<GridPoint>& pointVector,
+                                         const std::filesystem::path& outputFile, bool echo = true);
+
+/*
+* Writes the line segment of every line to file, one per line: x_1 y_1 x_2 y_2
+* The folder of file is created if it does not exist
+* throws std::runtime_error if the file can not be opened or written
+*/
+void writeFile(const std::vector<Line>& lines, const std::vector<GridPoint>& points,
+               const std::filesystem::path& file);
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <numeric>
+#include <vector>
+
+/*
+ * Direction from an origin point to another point, reduced by gcd and with its sign normalised
+ * so that all points on the same line through the origin share the same direction.
+ * Exact for integer coordinates, unlike a rounded double slope.
+ */
+class Direction {
+public:
+    Direction() = default;
+
+    Direction(std::int64_t deltaX, std::int64_t deltaY) : dx{deltaX}, dy{deltaY} {
+        const std::int64_t d = std::gcd(dx, dy);
+        if (d != 0) {
+            dx /= d;
+            dy /= d;
+        }
+        // Pointing left or straight down is the same line as pointing right or straight up
+        if (dx < 0 || (dx == 0 && dy < 0)) {
+            dx = -dx;
+            dy = -dy;
+        }
+    }
+
+    bool operator==(const Direction&) const = default;
+
+    std::int64_t dx{0};
+    std::int64_t dy{0};
+};
+
+/*
+ * A line through integer points: its direction and dy * x - dx * y, which is the same for all its points
+ */
+class LineKey {
+public:
+    LineKey() = default;
+
+    // The line through the point (x, y) with the given direction
+    LineKey(const Direction& dir, std::int64_t x, std::int64_t y) : direction{dir}, offset{dir.dy * x - dir.dx * y} {}
+
+    bool operator==(const LineKey&) const = default;
+
+    Direction direction;
+    std::int64_t offset{0};
+};
+
+// Hash for LineKey, to use it in std::unordered_map and std::unordered_set
+struct LineKeyHash {
+    std::size_t operator()(const LineKey& key) const {
+        std::uint64_t h = static_cast<std::uint64_t>(key.direction.dx);
+        h = h * 0x9E3779B97F4A7C15ULL ^ static_cast<std::uint64_t>(key.direction.dy);
+        h = h * 0x9E3779B97F4A7C15ULL ^ static_cast<std::uint64_t>(key.offset);
+        h ^= h >> 31;
+        return static_cast<std::size_t>(h);
+    }
+};
+
+/*
+ * Open-addressing hash table grouping point ids by their direction from a common origin.
+ * Point ids are kept in a flat arena: each bucket is a singly linked chain through the arena,
+ * so inserting never allocates once the arena and the slots have grown to their final size.
+ * The table is meant to be cleared and reused for every origin.
+ */
+class SlopeTable {
+public:
+    static constexpr std::uint32_t npos = 0xFFFFFFFF;
+
+    struct Bucket {
+        Direction key;
+        std::uint32_t head{npos};  // first arena entry, npos if the slot is empty
+        std::uint32_t tail{npos};  // last arena entry, to append in O(1)
+        std::uint32_t count{0};    // number of point ids in the chain
+    };
+
+    // Prepare the table for (at most) n insertions
+    explicit SlopeTable(std::size_t n = 0) { reset(n); }
+
+    // Remove all buckets, keeping enough slots for n insertions at a load factor <= 0.5
+    void reset(std::size_t n) {
+        std::size_t capacity = 16;
+        while (capacity < 2 * n) capacity *= 2;
+
+        if (slots.size() != capacity) {
+            slots.assign(capacity, Bucket{});
+        } else {
+            // Only the slots filled since the last reset need to be emptied
+            for (auto slot : used) slots[slot] = Bucket{};
+        }
+        ids.clear();
+        next.clear();
+        ids.reserve(n);
+        next.reserve(n);
+        used.clear();
+    }
+
+    // Append point id to the bucket for direction key
+    void insert(const Direction& key, std::uint32_t id) {
+        Bucket& b = find(key);
+        if (b.head == npos) {
+            b.key = key;
+            used.push_back(static_cast<std::uint32_t>(&b - slots.data()));
+        }
+
+        const auto entry = static_cast<std::uint32_t>(ids.size());
+        ids.push_back(id);
+        next.push_back(npos);
+
+        if (b.tail == npos) {
+            b.head = entry;
+        } else {
+            next[b.tail] = entry;
+        }
+        b.tail = entry;
+        ++b.count;
+    }
+
+    // First point id appended to bucket b
+    std::uint32_t front(const Bucket& b) const { return ids[b.head]; }
+
+    // Call f(bucket) for every non-empty bucket, in the order the buckets were first filled
+    template <typename F>
+    void forEachBucket(F&& f) const {
+        for (auto slot : used) f(slots[slot]);
+    }
+
+    // Call f(id) for every point id of bucket b, in insertion order
+    template <typename F>
+    void forEachId(const Bucket& b, F&& f) const {
+        for (auto entry = b.head; entry != npos; entry = next[entry]) f(ids[entry]);
+    }
+
+private:
+    // Linear probing, the table never fills up since reset() keeps the load factor <= 0.5
+    Bucket& find(const Direction& key) {
+        const std::size_t mask = slots.size() - 1;
+        std::size_t slot = hash(key) & mask;
+        while (slots[slot].head != npos && !(slots[slot].key == key)) {
+            slot = (slot + 1) & mask;
+        }
+        return slots[slot];
+    }
+
+    // splitmix64 finaliser over both components
+    static std::size_t hash(const Direction& key) {
+        std::uint64_t h = static_cast<std::uint64_t>(key.dx) * 0x9E3779B97F4A7C15ULL ^
+                          static_cast<std::uint64_t>(key.dy);
+        h ^= h >> 30;
+        h *= 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 27;
+        h *= 0x94D049BB133111EBULL;
+        h ^= h >> 31;
+        return static_cast<std::size_t>(h);
+    }
+
+    std::vector<Bucket> slots;         // open-addressing slots
+    std::vector<std::uint32_t> used;   // indices of the non-empty slots
+    std::vector<std::uint32_t> ids;    // arena of point ids
+    std::vector<std::uint32_t> next;   // next arena entry in the same bucket, npos ends a chain
+};
@@ -2,6 +2,7 @@
 
 #include <glm/vec2.hpp>
 #include <glm/vec4.hpp>
+#include <cstddef>
 #include <memory>
 #include <string_view>
 #include <span>
@@ -20,6 +21,9 @@ class Window {
 public:
     enum class UseVSync { Yes, No };
 
+    // Handle of geometry stored on the GPU by upload(), valid for the lifetime of the window
+    enum class Geometry : size_t {};
+
     Window(int width, int height, UseVSync sync);
     Window(const Window&) = delete;
     Window(Window&&) = delete;
@@ -47,12 +51,22 @@ public:
     // Clear the window with specific color, each channel is in range [0,1]
     void clear(glm::vec4 color);
 
-    // Draws points on screen
+    // Stores points on the GPU once, so that they can be drawn every frame without uploading them again.
+    // Any number of points can be stored, large inputs are split into several buffers
+    Geometry upload(std::span<const Point> points);
+
+    // Draws points on screen, they are uploaded on every call
     void drawPoints(std::span<const Point> points);
 
-    // Draws lines on screen, each pair of points represents a line
+    // Draws points on screen that were stored by upload()
+    void drawPoints(Geometry points);
+
+    // Draws lines on screen, each pair of points represents a line, they are uploaded on every call
     void drawLines(std::span<const Point> lines);
 
+    // Draws lines on screen that were stored by upload(), each pair of points represents a line
+    void drawLines(Geometry lines);
+
 private:
     struct Impl;
     std::unique_ptr<Impl> impl;
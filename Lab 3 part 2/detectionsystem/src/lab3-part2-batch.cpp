@@ -0,0 +1,237 @@
+#include <linesdiscoverysystem/readfiles.h>
+#include <linesdiscoverysystem/parallel.h>
+#include <linesdiscoverysystem/approximate.h>
+#include <linesdiscoverysystem/incremental.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+
+/*
+ * Non-interactive line discovery over many points files, without opening a window
+ *
+ * Usage: lab3-part2-batch [--output <folder>] [--jobs <n>] [--approximate <L>] [--recall] <points file or folder>...
+ *        lab3-part2-batch [--output <folder>] [--jobs <n>] --index <index file> [--append <points file>]...
+ *   --output       folder the segments-<name> files and timings.txt are written to, default data_dir/output
+ *   --jobs         number of files processed concurrently, default one per hardware thread
+ *   --approximate  use the sampling search for lines with at least L >= 4 points, see findLinesApproximate
+ *   --recall       also run the exact search and report the fraction of its lines (with >= L points) found
+ *   --index        keep the points and lines in this file, see IncrementalLineDetector, it is created if needed
+ *   --append       add the points of this file to the index, only the lines they are on are searched
+ * Every *.txt file in a given folder is processed. Files with the same name would write the same segments file,
+ * only the first of them is processed and the others fail.
+ * With --index the segments of all lines in the index are written to segments-<index file name>.
+ */
+
+namespace {
+
+struct Job {
+    std::filesystem::path input;
+    std::size_t n_points{0};
+    std::size_t n_lines{0};
+    double read_ms{0.0};
+    double detect_ms{0.0};
+    double write_ms{0.0};
+    double recall{-1.0};  // negative if not measured
+    std::string error{};  // empty if the file was processed
+};
+
+struct Options {
+    std::filesystem::path output = data_dir / "output";
+    unsigned jobs = 0;
+    std::size_t approximate = 0;  // 0 runs the exact search
+    bool recall = false;
+    std::vector<std::filesystem::path> inputs;
+    std::filesystem::path index{};  // empty if no index is used
+    std::vector<std::filesystem::path> append;
+};
+
+Options parseArguments(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if ((arg == "--output" || arg == "-o") && i + 1 < argc) {
+            options.output = argv[++i];
+        } else if ((arg == "--jobs" || arg == "-j") && i + 1 < argc) {
+            options.jobs = static_cast<unsigned>(std::max(std::atoi(argv[++i]), 0));
+        } else if ((arg == "--approximate" || arg == "-a") && i + 1 < argc) {
+            const int minPoints = std::atoi(argv[++i]);
+            if (minPoints < 4) {
+                throw std::runtime_error(fmt::format("--approximate needs 4 or more points per line, not {}", argv[i]));
+            }
+            options.approximate = static_cast<std::size_t>(minPoints);
+        } else if (arg == "--recall" || arg == "-r") {
+            options.recall = true;
+        } else if (arg == "--index" && i + 1 < argc) {
+            options.index = argv[++i];
+        } else if (arg == "--append" && i + 1 < argc) {
+            options.append.emplace_back(argv[++i]);
+        } else if (arg.starts_with("-")) {
+            throw std::runtime_error(fmt::format("unknown option {}", arg));
+        } else {
+            options.inputs.emplace_back(arg);
+        }
+    }
+    // Points files are either processed on their own or appended to an index
+    const bool usesIndex = !options.index.empty();
+    if (usesIndex ? !options.inputs.empty() : options.inputs.empty() || !options.append.empty()) {
+        throw std::runtime_error(
+            "usage: lab3-part2-batch [--output <folder>] [--jobs <n>] [--approximate <L>] [--recall] "
+            "<points file or folder>...\n"
+            "       lab3-part2-batch [--output <folder>] [--jobs <n>] --index <index file> "
+            "[--append <points file>]...");
+    }
+    return options;
+}
+
+// Expands folders to the points files they contain, in alphabetical order
+std::vector<Job> collectJobs(const std::vector<std::filesystem::path>& inputs) {
+    std::vector<Job> jobs;
+    for (const auto& input : inputs) {
+        if (std::filesystem::is_directory(input)) {
+            std::vector<std::filesystem::path> files;
+            for (const auto& entry : std::filesystem::directory_iterator(input)) {
+                if (entry.is_regular_file() && entry.path().extension() == ".txt") {
+                    files.push_back(entry.path());
+                }
+            }
+            std::sort(files.begin(), files.end());
+            for (auto& file : files) jobs.push_back({.input = std::move(file)});
+        } else {
+            jobs.push_back({.input = input});
+        }
+    }
+    return jobs;
+}
+
+// Fails every job whose segments file is already written by an earlier job, i.e. inputs with the same file name
+void rejectCollisions(std::vector<Job>& jobs) {
+    std::map<std::filesystem::path, const Job*> writers;
+    for (auto& job : jobs) {
+        const auto [it, inserted] = writers.emplace(job.input.filename(), &job);
+        if (!inserted) job.error = fmt::format("same output file as {}", it->second->input.string());
+    }
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Reads the points, finds the lines and writes the segments of one file
+void run(Job& job, const Options& options) try {
+    if (!job.error.empty()) return;
+    if (!std::filesystem::is_regular_file(job.input)) {
+        job.error = "file not found";
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    const auto points = readPoints(job.input);
+    job.read_ms = millisecondsSince(start);
+
+    // The files are already processed concurrently, so every file is searched on a single thread
+    start = std::chrono::steady_clock::now();
+    const auto lines = options.approximate == 0 ? findLines(points, 1)
+                                                : findLinesApproximate(points, {.minPoints = options.approximate}, 1);
+    job.detect_ms = millisecondsSince(start);
+
+    // Compare with the exact search, which is not included in the timings
+    if (options.recall) {
+        job.recall = lineRecall(findLines(points, 1), lines, std::max<std::size_t>(options.approximate, 4));
+    }
+
+    start = std::chrono::steady_clock::now();
+    writeFile(lines, points, segmentsFile(job.input.filename().string(), options.output));
+    job.write_ms = millisecondsSince(start);
+
+    job.n_points = points.size();
+    job.n_lines = lines.size();
+} catch (const std::exception& e) {
+    job.error = e.what();
+}
+
+// Loads the index, or starts a new one, adds the points of every appended file and saves the index again
+void runIndex(const Options& options) {
+    const auto start = std::chrono::steady_clock::now();
+
+    IncrementalLineDetector detector = std::filesystem::exists(options.index)
+                                           ? IncrementalLineDetector::load(options.index)
+                                           : IncrementalLineDetector{};
+
+    for (const auto& file : options.append) {
+        if (!std::filesystem::is_regular_file(file)) {
+            throw std::runtime_error(fmt::format("File {} not found", file.string()));
+        }
+        auto points = readPoints(file);
+
+        // The first points of a new index are searched from scratch, in parallel
+        if (detector.points().empty()) {
+            detector = IncrementalLineDetector{std::move(points), options.jobs};
+        } else {
+            detector.addPoints(points);
+        }
+    }
+
+    detector.save(options.index);
+
+    const auto lines = detector.lines();
+    writeFile(lines, detector.points(), segmentsFile(options.index.filename().string(), options.output));
+
+    fmt::print("{}: {} points, {} lines in {:.2f} ms\n", options.index.string(), detector.points().size(),
+               lines.size(), millisecondsSince(start));
+}
+
+// Per-file timing summary, one row per input file
+void writeSummary(std::ostream& out, const std::vector<Job>& jobs, double total_ms) {
+    out << fmt::format("{:<32} {:>8} {:>7} {:>10} {:>10} {:>10} {:>7}  {}\n", "file", "points", "lines", "read_ms",
+                       "detect_ms", "write_ms", "recall", "status");
+    for (const auto& job : jobs) {
+        out << fmt::format("{:<32} {:>8} {:>7} {:>10.2f} {:>10.2f} {:>10.2f} {:>7}  {}\n",
+                           job.input.filename().string(), job.n_points, job.n_lines, job.read_ms, job.detect_ms,
+                           job.write_ms, job.recall < 0.0 ? "-" : fmt::format("{:.3f}", job.recall),
+                           job.error.empty() ? "ok" : job.error);
+    }
+    out << fmt::format("{} files in {:.2f} ms\n", jobs.size(), total_ms);
+}
+
+}  // namespace
+
+/* ************************************* */
+
+int main(int argc, char* argv[]) try {
+    const Options options = parseArguments(argc, argv);
+    if (!options.index.empty()) {
+        std::filesystem::create_directories(options.output);
+        runIndex(options);
+        return 0;
+    }
+
+    std::vector<Job> jobs = collectJobs(options.inputs);
+    rejectCollisions(jobs);
+
+    std::filesystem::create_directories(options.output);
+
+    const auto start = std::chrono::steady_clock::now();
+    parallelFor(jobs.size(), options.jobs, [&](std::size_t i, unsigned) { run(jobs[i], options); });
+    const double total_ms = millisecondsSince(start);
+
+    writeSummary(std::cout, jobs, total_ms);
+
+    std::ofstream summary(options.output / "timings.txt");
+    writeSummary(summary, jobs, total_ms);
+
+    const bool failed = std::any_of(jobs.begin(), jobs.end(), [](const Job& job) { return !job.error.empty(); });
+    return failed ? 1 : 0;
+} catch (const std::exception& e) {
+    fmt::print("Error: {}\n", e.what());
+    return 1;
+}
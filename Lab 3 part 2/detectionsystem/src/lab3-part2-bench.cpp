@@ -0,0 +1,269 @@
+#include <linesdiscoverysystem/readfiles.h>
+#include <linesdiscoverysystem/parallel.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+/*
+ * Benchmark of the line discovery pipeline
+ *
+ * Usage: lab3-part2-bench [--threads <n>] [--repeat <r>] [--csv <file>] [--synthetic <n1,n2,...>]
+ *                         [--lines <k>] [--length <m>] [--seed <s>]
+ *   --threads    threads used by findLines, default one per hardware thread
+ *   --repeat     runs per input, the fastest run is reported, default 3
+ *   --csv        also write the results to this file
+ *   --synthetic  sizes of the generated point sets, default 1000,2000,4000,8000
+ *   --lines      number of lines planted in every generated point set, default 10
+ *   --length     number of points on every planted line, default 8
+ *
+ * Every bundled points file in data_dir is run, followed by the generated point sets. The inputs are run in
+ * order of size, so the (monotonic) peak resident set size reported after each input forms a curve as well.
+ * total_ms is wall time, the grouping phase is summed over all threads.
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    unsigned threads = 0;
+    int repeat = 3;
+    std::filesystem::path csv{};
+    std::vector<std::size_t> synthetic{1000, 2000, 4000, 8000};
+    std::size_t lines = 10;
+    std::size_t length = 8;
+    std::uint64_t seed = 2024;
+};
+
+struct Input {
+    std::string name;
+    std::filesystem::path file{};   // empty for generated point sets
+    std::size_t n_synthetic{0};
+};
+
+struct Result {
+    std::string name;
+    std::size_t n_points{0};
+    std::size_t n_lines{0};
+    double parse_ms{0.0};
+    DetectionTimings detection{};
+    double output_ms{0.0};
+    double total_ms{0.0};
+    double peak_rss_mb{0.0};
+};
+
+std::vector<std::size_t> parseSizes(std::string_view list) {
+    std::vector<std::size_t> sizes;
+    while (!list.empty()) {
+        const auto comma = list.find(',');
+        sizes.push_back(static_cast<std::size_t>(std::atoll(std::string{list.substr(0, comma)}.c_str())));
+        list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+    }
+    std::erase(sizes, std::size_t{0});
+    return sizes;
+}
+
+Options parseArguments(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--threads" && hasValue) {
+            options.threads = static_cast<unsigned>(std::max(std::atoi(argv[++i]), 0));
+        } else if (arg == "--repeat" && hasValue) {
+            options.repeat = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "--csv" && hasValue) {
+            options.csv = argv[++i];
+        } else if (arg == "--synthetic" && hasValue) {
+            options.synthetic = parseSizes(argv[++i]);
+        } else if (arg == "--lines" && hasValue) {
+            options.lines = static_cast<std::size_t>(std::max(std::atoi(argv[++i]), 0));
+        } else if (arg == "--length" && hasValue) {
+            options.length = static_cast<std::size_t>(std::max(std::atoi(argv[++i]), 4));
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = static_cast<std::uint64_t>(std::atoll(argv[++i]));
+        } else {
+            throw std::runtime_error(fmt::format("unknown option {}", arg));
+        }
+    }
+    return options;
+}
+
+// Peak resident set size of the process so far, in MiB
+double peakResidentSetMiB() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters{};
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return static_cast<double>(counters.PeakWorkingSetSize) / (1024.0 * 1024.0);
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return static_cast<double>(usage.ru_maxrss) / (1024.0 * 1024.0);  // bytes
+#else
+    return static_cast<double>(usage.ru_maxrss) / 1024.0;  // KiB
+#endif
+#endif
+}
+
+/*
+ * Writes a points file with n points in the format read by readPoints: `lines` planted lines of `length`
+ * points each, and uniformly random points filling up the rest
+ * Random points may happen to form a few extra lines, so the planted lines are a lower bound
+ */
+void generatePoints(const std::filesystem::path& file, std::size_t n, std::size_t lines, std::size_t length,
+                    std::uint64_t seed) {
+    std::mt19937_64 random(seed ^ n);
+    std::uniform_int_distribution<int> coordinate(0, 32767);
+    std::set<std::pair<int, int>> points;
+
+    for (std::size_t l = 0; l < lines && points.size() + length <= n; ++l) {
+        // A random direction short enough to fit the whole line inside [0, 32767]
+        const int step = static_cast<int>(32767 / length);
+        std::uniform_int_distribution<int> delta(-step, step);
+        int dx = 0;
+        int dy = 0;
+        while (dx == 0 && dy == 0) {
+            dx = delta(random);
+            dy = delta(random);
+        }
+
+        // A random start point, such that the last point is inside as well
+        const int span = static_cast<int>(length) - 1;
+        std::uniform_int_distribution<int> startX(std::max(0, -dx * span), std::min(32767, 32767 - dx * span));
+        std::uniform_int_distribution<int> startY(std::max(0, -dy * span), std::min(32767, 32767 - dy * span));
+        const int x0 = startX(random);
+        const int y0 = startY(random);
+
+        for (int t = 0; t <= span; ++t) points.emplace(x0 + dx * t, y0 + dy * t);
+    }
+    while (points.size() < n) {
+        points.emplace(coordinate(random), coordinate(random));
+    }
+
+    std::ofstream out(file);
+    out << points.size() << '\n';
+    for (const auto& [x, y] : points) out << x << ' ' << y << '\n';
+}
+
+double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Runs the pipeline on one input, repeat times, and keeps the fastest run
+Result run(const Input& input, const std::filesystem::path& file, const std::filesystem::path& output,
+           const Options& options) {
+    Result best{.name = input.name};
+    best.total_ms = std::numeric_limits<double>::infinity();
+
+    for (int r = 0; r < options.repeat; ++r) {
+        Result result{.name = input.name};
+
+        auto start = Clock::now();
+        const auto points = readPoints(file);
+        result.parse_ms = millisecondsSince(start);
+
+        const auto lines = findLines(points, options.threads, &result.detection);
+
+        const auto outputStart = Clock::now();
+        writeFile(lines, points, segmentsFile(input.name, output));
+        result.output_ms = millisecondsSince(outputStart);
+
+        // Wall time of the whole pipeline, the grouping phase is summed over all threads
+        result.total_ms = millisecondsSince(start);
+        result.n_points = points.size();
+        result.n_lines = lines.size();
+        if (result.total_ms < best.total_ms) best = result;
+    }
+    best.peak_rss_mb = peakResidentSetMiB();
+    return best;
+}
+
+std::string format(const Result& r, bool header = false) {
+    if (header) {
+        return fmt::format("{:<24} {:>8} {:>6} {:>10} {:>10} {:>11} {:>10} {:>10} {:>9}", "input", "points", "lines",
+                           "parse_ms", "sort_ms", "grouping_ms", "output_ms", "total_ms", "peak_mb");
+    }
+    return fmt::format("{:<24} {:>8} {:>6} {:>10.2f} {:>10.2f} {:>11.2f} {:>10.2f} {:>10.2f} {:>9.1f}", r.name,
+                       r.n_points, r.n_lines, r.parse_ms, r.detection.sort_ms, r.detection.grouping_ms, r.output_ms,
+                       r.total_ms, r.peak_rss_mb);
+}
+
+}  // namespace
+
+/* ************************************* */
+
+int main(int argc, char* argv[]) try {
+    const Options options = parseArguments(argc, argv);
+
+    const auto work = std::filesystem::temp_directory_path() / "lab3-part2-bench";
+    std::filesystem::create_directories(work);
+
+    // The bundled points files and the generated point sets
+    std::vector<Input> inputs;
+    for (const auto& entry : std::filesystem::directory_iterator(data_dir)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".txt") {
+            inputs.push_back({.name = entry.path().filename().string(), .file = entry.path()});
+        }
+    }
+    for (auto n : options.synthetic) {
+        inputs.push_back({.name = fmt::format("synthetic-{}.txt", n), .n_synthetic = n});
+    }
+
+    // Run in order of size, the number of points is the first value of every points file
+    auto sizeOf = [](const Input& input) {
+        if (input.n_synthetic != 0) return input.n_synthetic;
+        std::ifstream in(input.file);
+        std::size_t n{0};
+        in >> n;
+        return n;
+    };
+    std::stable_sort(inputs.begin(), inputs.end(),
+                     [&sizeOf](const Input& a, const Input& b) { return sizeOf(a) < sizeOf(b); });
+
+    std::cout << format({}, true) << '\n';
+
+    std::vector<Result> results;
+    for (const auto& input : inputs) {
+        std::filesystem::path file = input.file;
+        if (input.n_synthetic != 0) {
+            file = work / input.name;
+            generatePoints(file, input.n_synthetic, options.lines, options.length, options.seed);
+        }
+        results.push_back(run(input, file, work, options));
+        std::cout << format(results.back()) << std::endl;
+    }
+
+    if (!options.csv.empty()) {
+        std::ofstream csv(options.csv);
+        csv << "input,points,lines,threads,parse_ms,sort_ms,grouping_ms,output_ms,total_ms,peak_rss_mb\n";
+        for (const auto& r : results) {
+            csv << fmt::format("{},{},{},{},{:.3f},{:.3f},{:.3f},{:.3f},{:.3f},{:.1f}\n", r.name, r.n_points,
+                               r.n_lines, workerCount(options.threads), r.parse_ms, r.detection.sort_ms,
+                               r.detection.grouping_ms, r.output_ms, r.total_ms, r.peak_rss_mb);
+        }
+    }
+} catch (const std::exception& e) {
+    fmt::print("Error: {}\n", e.what());
+    return 1;
+}
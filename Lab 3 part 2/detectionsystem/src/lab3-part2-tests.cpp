@@ -0,0 +1,95 @@
+#include <linesdiscoverysystem/readfiles.h>
+#include <linesdiscoverysystem/approximate.h>
+#include <linesdiscoverysystem/incremental.h>
+
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+/*
+ * Checks of the line searches on small point sets, run by ctest
+ *
+ * Usage: lab3-part2-tests
+ * Prints one line per failed check and returns 1 if any check failed.
+ */
+
+namespace {
+
+int failures = 0;
+
+std::string format(const std::vector<Line>& lines) {
+    std::string text;
+    for (const Line& line : lines) {
+        text += "[";
+        for (std::size_t i = 0; i < line.size(); ++i) text += fmt::format("{}{}", i > 0 ? "," : "", line[i]);
+        text += "]";
+    }
+    return text;
+}
+
+void check(const std::string& name, const std::vector<Line>& found, const std::vector<Line>& expected) {
+    if (found != expected) {
+        fmt::print("FAIL {}: found {}, expected {}\n", name, format(found), format(expected));
+        ++failures;
+    }
+}
+
+// Every search finds the expected lines, the incremental one also when the points are added one at a time
+void checkSearches(const std::string& name, const std::vector<GridPoint>& points, const std::vector<Line>& expected) {
+    for (unsigned threads : {1u, 4u}) {
+        check(fmt::format("{} findLines threads={}", name, threads), findLines(points, threads), expected);
+    }
+
+    // Every point is an origin when the failure probability is tiny
+    check(name + " findLinesApproximate",
+          findLinesApproximate(points, {.minPoints = 4, .failureProbability = 1e-12}, 1), expected);
+
+    IncrementalLineDetector detector;
+    for (const GridPoint& p : points) detector.addPoints({p});
+    check(name + " IncrementalLineDetector", detector.lines(), expected);
+}
+
+}  // namespace
+
+/* ************************************* */
+
+int main() {
+    checkSearches("distinct points", {{0, 0}, {1, 1}, {2, 2}, {3, 3}, {0, 1}}, {{0, 1, 2, 3}});
+
+    // A duplicated point is on every line through it, and the line is reported once
+    checkSearches("duplicated first point", {{0, 0}, {0, 0}, {1, 1}, {2, 2}, {3, 3}}, {{0, 1, 2, 3, 4}});
+    checkSearches("duplicated inner point", {{3, 3}, {1, 1}, {0, 0}, {1, 1}, {5, 0}}, {{2, 1, 3, 0}});
+
+    // Copies count as points of the line
+    checkSearches("three distinct points", {{2, 2}, {0, 0}, {1, 1}, {0, 0}}, {{1, 3, 2, 0}});
+    checkSearches("only copies", {{4, 4}, {4, 4}, {4, 4}, {4, 4}}, {});
+
+    // Two lines through the same duplicated point
+    checkSearches("two lines", {{0, 0}, {1, 1}, {2, 2}, {0, 0}, {1, 0}, {2, 0}},
+                  {{0, 3, 4, 5}, {0, 3, 1, 2}});
+
+    // Long lines among scattered points, few enough pairs are sampled that the approximate search does not fall back
+    // to findLines
+    {
+        std::vector<GridPoint> points;
+        for (std::int32_t k = 0; k < 40; ++k) {
+            points.push_back({k, 2 * k});
+            points.push_back({3 * k + 1, 1000});
+            points.push_back({500, 7 * k + 3});
+        }
+        std::mt19937 random(7);
+        std::uniform_int_distribution<std::int32_t> coordinate(0, 32767);
+        for (int k = 0; k < 400; ++k) points.push_back({coordinate(random), coordinate(random)});
+
+        std::vector<Line> expected = findLines(points, 1);
+        std::erase_if(expected, [](const Line& line) { return line.size() < 20; });
+        check("long lines findLinesApproximate",
+              findLinesApproximate(points, {.minPoints = 20, .failureProbability = 1e-9}, 4), expected);
+    }
+
+    if (failures == 0) fmt::print("All checks passed\n");
+    return failures == 0 ? 0 : 1;
+}
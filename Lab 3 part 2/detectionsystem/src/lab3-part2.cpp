@@ -28,17 +28,20 @@ void plotData(const std::string& name) {
     std::filesystem::path points_name = name;
     const auto points = readPoints(data_dir / points_name);
 
-    writeLines(points, name);
-
-    std::filesystem::path segments_name = "segments-" + name;
-    const auto lines = readLineSegments(data_dir / "output" / segments_name);
+    // The segments are written to data_dir/output and handed back for rendering
+    const auto lines = writeLines(points, segmentsFile(name));
 
     rendering::Window window(850, 850, rendering::Window::UseVSync::Yes);
+
+    // Nothing changes between frames, so everything is uploaded to the GPU once
+    const auto lineGeometry = window.upload(lines);
+    const auto pointGeometry = window.upload(renderPoints(points));
+
     while (!window.shouldClose()) {
         window.beginFrame();
         window.clear({0, 0, 0, 1});
-        window.drawLines(lines);    // to plot the line segments discovered
-        window.drawPoints(points);  // to plot input points
+        window.drawLines(lineGeometry);    // to plot the line segments discovered
+        window.drawPoints(pointGeometry);  // to plot input points
         window.endFrame();
     }
 }
\ No newline at end of file
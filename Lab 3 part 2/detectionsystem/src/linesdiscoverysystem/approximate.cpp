@@ -0,0 +1,148 @@
+#include <linesdiscoverysystem/approximate.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <set>
+#include <unordered_set>
+
+#include <linesdiscoverysystem/slopetable.h>
+#include <linesdiscoverysystem/parallel.h>
+
+namespace {
+
+// The sampled pairs are split into this many ranges, each with its own random numbers, so that the sample does
+// not depend on the number of threads
+constexpr std::size_t sampleRanges = 64;
+
+// Above this sampling rate the exact search does less work than sampling and counting the pairs
+constexpr double maxSamplingRate = 0.25;
+
+// Probability that fewer than two of the pairs of a line of m points are sampled at the given rate
+double missProbability(std::size_t m, double rate) {
+    const double pairs = static_cast<double>(m) * static_cast<double>(m - 1) / 2.0;
+    const double none = std::pow(1.0 - rate, pairs);
+    return none + pairs * rate * std::pow(1.0 - rate, pairs - 1.0);
+}
+
+// Smallest sampling rate, to a few digits, that misses a line of m points with at most the given probability
+double samplingRate(std::size_t m, double failureProbability) {
+    double lo = 0.0;
+    double hi = 1.0;
+    for (int k = 0; k < 50; ++k) {
+        const double mid = (lo + hi) / 2.0;
+        (missProbability(m, mid) <= failureProbability ? hi : lo) = mid;
+    }
+    return hi;
+}
+
+}  // namespace
+
+std::vector<Line> findLinesApproximate(const std::vector<GridPoint>& points, const ApproximateOptions& options,
+                                       unsigned threads) {
+    const std::size_t n = points.size();
+    const std::size_t minPoints = std::max<std::size_t>(options.minPoints, 4);
+    if (n < minPoints) return {};
+
+    const double rate = samplingRate(minPoints, std::clamp(options.failureProbability, 1e-12, 1.0));
+    if (rate > maxSamplingRate) {
+        std::vector<Line> lines = findLines(points, threads);
+        std::erase_if(lines, [minPoints](const Line& line) { return line.size() < minPoints; });
+        return lines;
+    }
+
+    // Pair (i, j), i < j, has the index rowStart[i] + (j - i - 1)
+    std::vector<std::uint64_t> rowStart(n + 1, 0);
+    for (std::size_t i = 0; i < n; ++i) rowStart[i + 1] = rowStart[i] + (n - 1 - i);
+    const std::uint64_t pairs = rowStart[n];
+
+    // Calls f(key) for the line through every sampled pair of range r. Every pair is taken with probability rate,
+    // the gap to the next taken pair is geometric, so only the taken pairs cost time.
+    auto forEachSample = [&](std::size_t r, auto&& f) {
+        const std::uint64_t first = pairs * r / sampleRanges;
+        const std::uint64_t last = pairs * (r + 1) / sampleRanges;
+
+        std::mt19937_64 random(options.seed ^ (0x9E3779B97F4A7C15ULL * (r + 1)));
+        std::geometric_distribution<std::uint64_t> gap(rate);
+
+        std::size_t i = static_cast<std::size_t>(std::upper_bound(rowStart.begin(), rowStart.end(), first) -
+                                                 rowStart.begin()) - 1;
+        for (std::uint64_t pair = first + gap(random); pair < last; pair += 1 + gap(random)) {
+            while (rowStart[i + 1] <= pair) ++i;
+            const GridPoint p = points[i];
+            const GridPoint q = points[i + 1 + static_cast<std::size_t>(pair - rowStart[i])];
+            if (p == q) continue;  // duplicated points do not define a line
+            f(LineKey{Direction{q.x - p.x, q.y - p.y}, p.x, p.y});
+        }
+    };
+
+    // Vote: the hash of the line through every sampled pair
+    std::vector<std::vector<std::uint64_t>> votes(sampleRanges);
+    parallelFor(sampleRanges, threads, [&](std::size_t r, unsigned) {
+        votes[r].reserve(static_cast<std::size_t>(static_cast<double>(pairs) * rate / sampleRanges * 1.1) + 16);
+        forEachSample(r, [&](const LineKey& key) { votes[r].push_back(LineKeyHash{}(key)); });
+    });
+
+    // Lines with two or more votes are candidates, a line through two random points gets one vote
+    std::vector<std::uint64_t> hashes;
+    for (auto& v : votes) {
+        hashes.insert(hashes.end(), v.begin(), v.end());
+        std::vector<std::uint64_t>().swap(v);
+    }
+    std::sort(hashes.begin(), hashes.end());
+    std::vector<std::uint64_t> repeated;
+    for (std::size_t k = 1; k < hashes.size(); ++k) {
+        if (hashes[k] == hashes[k - 1] && (repeated.empty() || repeated.back() != hashes[k])) {
+            repeated.push_back(hashes[k]);
+        }
+    }
+    std::vector<std::uint64_t>().swap(hashes);
+
+    // Draw the same pairs again to recover the lines behind the repeated hashes
+    const unsigned workers = workerCount(threads);
+    std::vector<std::unordered_set<LineKey, LineKeyHash>> found(workers);
+    parallelFor(sampleRanges, workers, [&](std::size_t r, unsigned worker) {
+        forEachSample(r, [&](const LineKey& key) {
+            if (std::binary_search(repeated.begin(), repeated.end(), LineKeyHash{}(key))) found[worker].insert(key);
+        });
+    });
+    std::unordered_set<LineKey, LineKeyHash> candidates;
+    for (auto& f : found) candidates.insert(f.begin(), f.end());
+    const std::vector<LineKey> keys(candidates.begin(), candidates.end());
+
+    // Verify every candidate against all points, which also makes every reported line complete. O(n) per candidate
+    std::vector<Line> verified(keys.size());
+    parallelFor(keys.size(), workers, [&](std::size_t k, unsigned) {
+        const LineKey& key = keys[k];
+        Line line;
+        for (std::uint32_t j = 0; j < n; ++j) {
+            if (key.direction.dy * points[j].x - key.direction.dx * points[j].y == key.offset) line.push_back(j);
+        }
+        if (line.size() < minPoints) return;
+
+        // In the order of findLines, by point and then by index
+        std::stable_sort(line.begin(), line.end(), [&points](std::uint32_t a, std::uint32_t b) { return points[a] < points[b]; });
+        verified[k] = std::move(line);
+    });
+
+    std::vector<Line> lines;
+    for (auto& line : verified) {
+        if (!line.empty()) lines.push_back(std::move(line));
+    }
+    sortLines(lines, points);
+    return lines;
+}
+
+double lineRecall(const std::vector<Line>& exact, const std::vector<Line>& found, std::size_t minPoints) {
+    // Lines are identified by their sorted point indices
+    const std::set<Line> reported(found.begin(), found.end());
+
+    std::size_t wanted = 0;
+    std::size_t hits = 0;
+    for (const Line& line : exact) {
+        if (line.size() < minPoints) continue;
+        ++wanted;
+        if (reported.contains(line)) ++hits;
+    }
+    return wanted == 0 ? 1.0 : static_cast<double>(hits) / static_cast<double>(wanted);
+}
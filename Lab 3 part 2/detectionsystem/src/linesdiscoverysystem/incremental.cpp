@@ -0,0 +1,148 @@
+#include <linesdiscoverysystem/incremental.h>
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include <linesdiscoverysystem/bufferedwriter.h>
+
+#include <fmt/format.h>
+
+IncrementalLineDetector::IncrementalLineDetector(std::vector<GridPoint> points, unsigned threads)
+    : pointVector(std::move(points)) {
+    // The initial point set is searched from scratch, in parallel
+    lineVector = findLines(pointVector, threads);
+    for (std::uint32_t i = 0; i < lineVector.size(); ++i) {
+        index.emplace(keyOf(lineVector[i]), i);
+    }
+}
+
+void IncrementalLineDetector::addPoints(const std::vector<GridPoint>& newPoints) {
+    pointVector.reserve(pointVector.size() + newPoints.size());
+
+    for (const auto& p : newPoints) {
+        pointVector.push_back(p);
+        addPoint(static_cast<std::uint32_t>(pointVector.size() - 1));
+    }
+}
+
+std::vector<Line> IncrementalLineDetector::lines() const {
+    std::vector<Line> result = lineVector;
+    sortLines(result, pointVector);
+    return result;
+}
+
+void IncrementalLineDetector::addPoint(std::uint32_t point) {
+    const GridPoint p = pointVector[point];
+
+    // Group the points already indexed by their direction from the new point. Time complexity: O(n) expected
+    table.reset(point);
+    Line copies;
+    for (std::uint32_t j = 0; j < point; ++j) {
+        // Duplicated points do not define a direction, but they are on every line through the new point
+        if (pointVector[j] == p) {
+            copies.push_back(j);
+            continue;
+        }
+
+        table.insert(Direction{pointVector[j].x - p.x, pointVector[j].y - p.y}, j);
+    }
+
+    // Sorted by x and then y, like the lines returned by findLines
+    auto before = [this](std::uint32_t a, std::uint32_t b) {
+        return pointVector[a] < pointVector[b] || (pointVector[a] == pointVector[b] && a < b);
+    };
+
+    // Only lines with three or more old points (copies of the new point included) become lines of four or more
+    table.forEachBucket([&](const SlopeTable::Bucket& bucket) {
+        if (bucket.count + copies.size() < 3) return;
+
+        const LineKey key = keyOf(bucket.key, point);
+        if (auto it = index.find(key); it != index.end()) {
+            // Extend the known line, all its points are in the bucket or copies of the new point already
+            Line& line = lineVector[it->second];
+            line.insert(std::upper_bound(line.begin(), line.end(), point, before), point);
+        } else {
+            // The new point completes a line
+            Line& line = lineVector.emplace_back();
+            line.reserve(bucket.count + copies.size() + 1);
+            table.forEachId(bucket, [&line](std::uint32_t j) { line.push_back(j); });
+            line.insert(line.end(), copies.begin(), copies.end());
+            line.push_back(point);
+            std::sort(line.begin(), line.end(), before);
+            index.emplace(key, static_cast<std::uint32_t>(lineVector.size() - 1));
+        }
+    });
+}
+
+LineKey IncrementalLineDetector::keyOf(const Direction& direction, std::uint32_t point) const {
+    return LineKey{direction, pointVector[point].x, pointVector[point].y};
+}
+
+LineKey IncrementalLineDetector::keyOf(const Line& line) const {
+    // The first points of a line can be copies of each other, the direction needs two different points
+    const GridPoint p = pointVector[line.front()];
+    const auto other = std::find_if(line.begin(), line.end(), [&](std::uint32_t id) { return pointVector[id] != p; });
+    const GridPoint q = (other != line.end()) ? pointVector[*other] : p;
+    return keyOf(Direction{q.x - p.x, q.y - p.y}, line.front());
+}
+
+/*
+ * File format, all values are integers:
+ *   lsd-index 1
+ *   <number of points>
+ *   x y                          -- one line per point
+ *   <number of lines>
+ *   <count> id_1 id_2 ... id_n   -- one line per discovered line
+ */
+void IncrementalLineDetector::save(const std::filesystem::path& file) const {
+    std::ofstream out(file);
+    if (!out) {
+        throw std::runtime_error(fmt::format("Can not write line index {}", file.string()));
+    }
+
+    BufferedWriter writer(out);
+    writer.print("lsd-index 1\n{}\n", pointVector.size());
+    for (const auto& [x, y] : pointVector) writer.print("{} {}\n", x, y);
+
+    writer.print("{}\n", lineVector.size());
+    for (const Line& line : lineVector) {
+        writer.print("{}", line.size());
+        for (auto id : line) writer.print(" {}", id);
+        writer.print("\n");
+    }
+}
+
+IncrementalLineDetector IncrementalLineDetector::load(const std::filesystem::path& file) {
+    std::ifstream in(file);
+    std::string magic;
+    int version{0};
+    if (!(in >> magic >> version) || magic != "lsd-index" || version != 1) {
+        throw std::runtime_error(fmt::format("{} is not a line index", file.string()));
+    }
+
+    IncrementalLineDetector detector;
+
+    std::size_t n_points{0};
+    in >> n_points;
+    detector.pointVector.resize(n_points);
+    for (auto& p : detector.pointVector) in >> p.x >> p.y;
+
+    std::size_t n_lines{0};
+    in >> n_lines;
+    detector.lineVector.resize(n_lines);
+    for (std::uint32_t i = 0; i < n_lines; ++i) {
+        Line& line = detector.lineVector[i];
+        std::size_t count{0};
+        in >> count;
+        line.resize(count);
+        for (auto& id : line) in >> id;
+
+        if (!in || count < 2 || std::any_of(line.begin(), line.end(), [n_points](auto id) { return id >= n_points; })) {
+            throw std::runtime_error(fmt::format("Corrupt line index {}", file.string()));
+        }
+        detector.index.emplace(detector.keyOf(line), i);
+    }
+    return detector;
+}
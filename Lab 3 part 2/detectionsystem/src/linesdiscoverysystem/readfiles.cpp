@@ -4,8 +4,16 @@
 #include <string>
 #include <fstream>
 #include <algorithm>
-#include<set>
-#include <cmath>
+#include <numeric>
+#include <limits>
+#include <cstdint>
+#include <utility>
+#include <chrono>
+#include <stdexcept>
+
+#include <linesdiscoverysystem/slopetable.h>
+#include <linesdiscoverysystem/parallel.h>
+#include <linesdiscoverysystem/bufferedwriter.h>
 
 
 std::vector<rendering::Point> readLineSegments(std::ifstream& file) {
@@ -39,26 +47,24 @@ std::vector<rendering::Point> readLineSegments(const std::filesystem::path& file
     return readLineSegments(linesFile);
 }
 
-std::vector<rendering::Point> readPoints(std::istream& is) {
+std::vector<GridPoint> readPoints(std::istream& is) {
     int n_points{0};
     is >> n_points;  // read number of particles
 
-    std::vector<rendering::Point> points;
+    std::vector<GridPoint> points;
     points.reserve(n_points);
     for (int i = 0; i < n_points; ++i) {
-        auto& p = points.emplace_back(glm::vec2{}, glm::vec4{1.0f, 1.0f, 0.0f, 1.0f}, 0.002f);
-        is >> p.position.x >> p.position.y;
-        p.position.x /= 32767.0;
-        p.position.y /= 32767.0;
+        auto& p = points.emplace_back();
+        is >> p.x >> p.y;
     }
     return points;
 }
 
 /*
  * Reads all points from a given input file -- see folder detectionsystem\data
- * Returns a vector of points that can be rendered
+ * Returns a vector with the integer coordinates of the points
  */
-std::vector<rendering::Point> readPoints(const std::filesystem::path& file) {
+std::vector<GridPoint> readPoints(const std::filesystem::path& file) {
     std::ifstream pointsFile(file);
     if (!pointsFile) {
         std::cout << "Points file error!!\n";
@@ -67,233 +73,207 @@ std::vector<rendering::Point> readPoints(const std::filesystem::path& file) {
     return readPoints(pointsFile);
 }
 
-
-
-class Slope {
-public:
-    double k;
-    double m;
-};
-
-
-class PointSlope {
-public:
-    rendering::Point point;
-    Slope slope;
-};
-
-// Used by std::stable_sort
-bool operator<(const PointSlope& lhs, const PointSlope& rhs) { 
-    // If the k-values are the same we want to sort by m-value
-    if (lhs.slope.k == rhs.slope.k) {
-        // If the m-values are the same we want to sort by x-value
-        if (lhs.slope.m == rhs.slope.m) {
-            // If the x-values are the same we want to sort by y-value
-            if (lhs.point.position.x == rhs.point.position.x) {
-                // Sort by y-value increasingly
-                return lhs.point.position.y < rhs.point.position.y;
-            } else {
-                // Sort by x-value increasingly
-                return lhs.point.position.x < rhs.point.position.x;
-            }
-        } else {
-            // Sort by m-value increasingly
-            return lhs.slope.m < rhs.slope.m;
-        }
-    } else {
-        // Sort by k-value increasingly
-        return lhs.slope.k < rhs.slope.k;
+/*
+ * Converts points to points that can be rendered, coordinates are scaled to [0, 1]
+ */
+std::vector<rendering::Point> renderPoints(const std::vector<GridPoint>& points) {
+    std::vector<rendering::Point> rendered;
+    rendered.reserve(points.size());
+    for (const auto& p : points) {
+        rendered.emplace_back(glm::vec2{p.x / 32767.0f, p.y / 32767.0f}, glm::vec4{1.0f, 1.0f, 0.0f, 1.0f}, 0.002f);
     }
+    return rendered;
 }
 
+namespace {
 
-// The main bulk of the program, reads all points and calculates their slopes, sorts these points and decides what points are part of a line
-void writeLines(std::vector<rendering::Point> pointVector, std::string pointPath) {
-    
-    // Temporary values updated throught the following for-loop
-    PointSlope ps;
-    rendering::Point p;
-    rendering::Point q;
-
-    // Vector to store all possible slopes that appear in pointVector
-    std::vector<PointSlope> slopes{};
-
-    // If pointVector got size n, Slopes will need n^2 in size
-    slopes.reserve(pointVector.size() * pointVector.size());
-
-    // Read from pointVector time complexity: O(n^2)
-    for (size_t i = 0; i < pointVector.size(); i++) {
+using Clock = std::chrono::steady_clock;
 
-        // Set p to the current position in pointVector
-        p = pointVector[i];
-        p.position.x *= 32767.0;
-        p.position.y *= 32767.0;
-
-        // Define the pointSlope point as p
-        ps.point = p;
-
-        // Calculate all possible slopes for a given point p
-        for (size_t j = 0; j < (pointVector.size());j++) {
-            // If we have reached the last element in pointVector we save what we have to slopes, this being the current point i and the last calculated slope
-            if (j + 1 ==  pointVector.size()) {
-                slopes.push_back(ps);
-                continue;
-            }
+double millisecondsBetween(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
 
-            // Set q to the next position in pointVector
-            q = pointVector[j + 1];
-            q.position.x *= 32767.0;
-            q.position.y *= 32767.0;
-
-            // Vertical slope
-            if (abs(q.position.x - p.position.x) < 1e-10) {
-                // Devision by 0 is not defined, thus the k-value is infinite
-                ps.slope.k = std::numeric_limits<double>::infinity();
-                
-                // For easier comparisons while deciding lines the m-value is set to the x-position of q, could also be that of p given that they have the same x-position.
-                ps.slope.m = q.position.x;
-            } 
-            // Horisontal slope
-            else if ((abs(q.position.y - p.position.y) < 1e-10)) {
-                // To ensure we get a perfeclty horisontal slope we set k to 0 given that doubles can result in rounding errors.
-                ps.slope.k = 0.0;
-
-                // Given that the m-value corresponds to where the line crosses the y-axis and we have a horisontal line we know that y = m.
-                ps.slope.m = q.position.y;
-            } 
-            // Normal slope
-            else {
-                // k = (y2 - y1) / (x2 - x1)
-                ps.slope.k = (q.position.y - p.position.y) / (q.position.x - p.position.x);
-
-                // m = y - k * x
-                ps.slope.m = q.position.y - ps.slope.k * q.position.x;
-                
-                // Round to 4 decimals, given problems with rounding of doubles
-                ps.slope.k = std::round(ps.slope.k * 10000.0) / 10000.0;
-                ps.slope.m = std::round(ps.slope.m * 10000.0) / 10000.0;
-            }
+}  // namespace
 
-            // Save the current point and it's slope to the vector slopes.
-            slopes.push_back(ps);
+/*
+ * Finds all lines through four or more points, groups the other points by their direction from every point.
+ * The work for each point is independent, so the points are split over a pool of worker threads.
+ */
+std::vector<Line> findLines(const std::vector<GridPoint>& pointVector, unsigned threads,
+                            DetectionTimings* timings) {
+    auto start = Clock::now();
+
+    // Visit the points sorted by x-value and then y-value, so that a line is only reported from its first point.
+    // The sort is stable, so that duplicated points stay in input order.
+    std::vector<std::uint32_t> order(pointVector.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+              [&pointVector](std::uint32_t a, std::uint32_t b) { return pointVector[a] < pointVector[b]; });
+
+    // The points in that order, so that the hot loop below reads them sequentially
+    std::vector<GridPoint> sorted(order.size());
+    std::transform(order.begin(), order.end(), sorted.begin(), [&pointVector](std::uint32_t i) { return pointVector[i]; });
+
+    double sort_ms = millisecondsBetween(start, Clock::now());
+
+    // Every worker has its own table and discovered lines, so they never have to synchronise
+    const unsigned workers = workerCount(threads);
+    std::vector<SlopeTable> tables(workers);
+    std::vector<std::vector<Line>> found(workers);
+    std::vector<double> grouping_ms(workers, 0.0);
+
+    // Time complexity: O(n^2) expected, each point is hashed once for every other point
+    parallelFor(order.size(), workers, [&](std::size_t i, unsigned worker) {
+        SlopeTable& table = tables[worker];
+        const GridPoint p = sorted[i];
+
+        // The lines through a duplicated point are reported from its first copy only
+        if (i > 0 && sorted[i - 1] == p) return;
+
+        // The copies of p directly follow it in sorted order
+        std::size_t copies = 0;
+        while (i + copies + 1 < sorted.size() && sorted[i + copies + 1] == p) ++copies;
+
+        // The clock is only read when the timings are wanted
+        const auto groupingStart = timings ? Clock::now() : Clock::time_point{};
+
+        // Group all other points by their direction from p, which is computed as the point is inserted
+        // The coordinates are integers, so the direction can be compared exactly
+        table.reset(pointVector.size());
+        for (size_t j = 0; j < sorted.size(); j++) {
+            // p itself and duplicates of p do not define a direction
+            if (sorted[j] == p) continue;
+
+            table.insert(Direction{sorted[j].x - p.x, sorted[j].y - p.y}, static_cast<std::uint32_t>(j));
         }
-    }
-
-    // sort slopes according to the operator<
-    std::stable_sort(slopes.begin(), slopes.end());     // Time complexity: O(nlogn)
 
-    // Erase possible duplicates that might be saved in slopes
-    std::set<PointSlope> set(slopes.begin(), slopes.end()); // Time complexity: O(nlogn)
+        // Points sharing a direction from p are on the same line as p. A line is found from each of its points, keep it
+        // only if it has four or more points (copies included) and p is its lexicographically smallest point.
+        table.forEachBucket([&](const SlopeTable::Bucket& bucket) {
+            if (bucket.count + copies < 3 || table.front(bucket) < i) return;
 
-    // Reassign the set to a vector
-    slopes.assign(set.begin(), set.end()); // Time complexity: O(n)
-   
-    // Given that each line must have at least four points we can assume that dubVec wont be bigger than pointVector.size()/4 thus we can reserve that size for dubVec.
-    std::vector<std::vector<PointSlope>> dubVec{};  // Discovered lines, dubVec = "double Vector".
-    dubVec.reserve(pointVector.size() / 4);
+            Line& line = found[worker].emplace_back();
+            line.reserve(bucket.count + copies + 1);
+            for (std::size_t c = 0; c <= copies; ++c) line.push_back(order[i + c]);
+            table.forEachId(bucket, [&](std::uint32_t j) { line.push_back(order[j]); });
+        });
 
-    // Temporary vector to store possible lines before they are saved to dubVec.
-    std::vector<PointSlope> tempVec{};
+        if (timings) grouping_ms[worker] += millisecondsBetween(groupingStart, Clock::now());
+    });
 
-    for (size_t i = 0; i < slopes.size(); i++) {
+    start = Clock::now();
 
-        // The last element in the vector slopes
-        if (i + 1 == slopes.size()) {
-            tempVec.push_back(slopes[i]);
+    // Merge the per-thread results
+    std::vector<Line> lines{};
+    for (auto& f : found) {
+        lines.insert(lines.end(), std::make_move_iterator(f.begin()), std::make_move_iterator(f.end()));
+    }
 
-            // Save the line only if tempVec contains four or more points with the same slope.
-            if (tempVec.size() >= 4) dubVec.push_back(tempVec);
+    // Sort the lines, so that the result does not depend on how the points were split over the threads
+    sortLines(lines, pointVector);
 
-            // Clear tempVec to free up memory
-            tempVec.clear();
-        } 
-        else {
-            // Special if-statement that works for both normal lines and for std::numeric_limits<double>::infinity()
-            if ((slopes[i].slope.k == slopes[i + 1].slope.k || abs(slopes[i].slope.k - slopes[i + 1].slope.k) < 1e-10) &&
-                 (slopes[i].slope.m == slopes[i + 1].slope.m || abs(slopes[i].slope.m - slopes[i + 1].slope.m) < 1e-10)) {
+    sort_ms += millisecondsBetween(start, Clock::now());
 
-                // Temporarily save save this point to tempVec
-                tempVec.push_back(slopes[i]);
+    if (timings) {
+        *timings = DetectionTimings{.sort_ms = sort_ms,
+                                    .grouping_ms = std::accumulate(grouping_ms.begin(), grouping_ms.end(), 0.0)};
+    }
 
-            // The next point does not share both k- and m-values with the current point thus we have found the end of a possible line
-            } else {
+    return lines;
+}
 
-                tempVec.push_back(slopes[i]);
+// Sorts the lines by k-value and then m-value (and first point, if the doubles tie). Time complexity: O(LlogL) for L lines
+void sortLines(std::vector<Line>& lines, const std::vector<GridPoint>& pointVector) {
+    // The k-value and m-value of a line, the m-value of a vertical line is its x-position
+    auto slopeOf = [&pointVector](const Line& line) {
+        const auto [x1, y1] = pointVector[line.front()];
+        const auto [x2, y2] = pointVector[line.back()];
+        if (x1 == x2) {
+            return std::pair{std::numeric_limits<double>::infinity(), static_cast<double>(x1)};
+        }
+        const double k = static_cast<double>(y2 - y1) / static_cast<double>(x2 - x1);
+        return std::pair{k, y1 - k * x1};
+    };
+
+    std::sort(lines.begin(), lines.end(), [&](const Line& lhs, const Line& rhs) {
+        const auto l = slopeOf(lhs);
+        const auto r = slopeOf(rhs);
+        if (l != r) return l < r;
+        return pointVector[lhs.front()] < pointVector[rhs.front()];
+    });
+}
 
-               // Save the line only if tempVec contains four or more points with the same slope.
-                if (tempVec.size() >= 4) {
-                    dubVec.push_back(tempVec);
-                }
+// Line segments that can be rendered, the first and last point of every line
+std::vector<rendering::Point> lineSegments(const std::vector<Line>& lines, const std::vector<GridPoint>& points) {
+    std::vector<rendering::Point> segments;
+    segments.reserve(2 * lines.size());
 
-                // Clear tempVec to move on to the next point
-                tempVec.clear();
-            }
-        }
+    rendering::Point start(glm::vec2{}, glm::vec4{1.0f, 1.0f, 0.0f, 1.0f}, 0.002f);
+    rendering::Point end(glm::vec2{}, glm::vec4{1.0f, 1.0f, 0.0f, 1.0f}, 0.002f);
+    for (const Line& line : lines) {
+        start.position = glm::vec2{points[line.front()].x / 32767.0f, points[line.front()].y / 32767.0f};
+        end.position = glm::vec2{points[line.back()].x / 32767.0f, points[line.back()].y / 32767.0f};
+        segments.insert(segments.end(), {start, end});
     }
+    return segments;
+}
+
+// The file the line segments discovered among the points of pointsName are written to
+std::filesystem::path segmentsFile(const std::string& pointsName, const std::filesystem::path& outputDir) {
+    return outputDir / ("segments-" + pointsName);
+}
 
-    // Write all lines to the console according to the format seen in the lab PM. Time complexity O(n^2).
-    for (size_t i = 0; i < dubVec.size(); i++) {
-        for (size_t j = 0; j < dubVec[i].size(); j++) {
-            // Last point
-            if (j + 1 == dubVec[i].size()) {
-                std::cout << "(" << std::to_string(static_cast<int>(dubVec[i][j].point.position.x)) << ","
-                                        << std::to_string(static_cast<int>(dubVec[i][j].point.position.y)) << ")\n";
-            // All other points
-            } else {
-                std::cout << "(" << std::to_string(static_cast<int>(dubVec[i][j].point.position.x)) << ","
-                          << std::to_string(static_cast<int>(dubVec[i][j].point.position.y))<< ")->";
+// The main bulk of the program, finds all lines among the points, writes them to file, and to the console if echo is set
+std::vector<rendering::Point> writeLines(const std::vector<GridPoint>& pointVector,
+                                         const std::filesystem::path& outputFile, bool echo) {
+
+    // Discovered lines, dubVec = "double Vector".
+    const std::vector<Line> dubVec = findLines(pointVector);
+
+    // Write all lines to the console according to the format seen in the lab PM. Time complexity O(n).
+    if (echo) {
+        BufferedWriter console(std::cout);
+        for (const Line& line : dubVec) {
+            for (size_t j = 0; j < line.size(); j++) {
+                const auto [x, y] = pointVector[line[j]];
+                // Last point ends the line, all other points are followed by an arrow
+                console.print("({},{}){}", x, y, j + 1 == line.size() ? "\n" : "->");
             }
         }
     }
 
-    // The vector Lines will store all start and end coordinates of the discovered lines in dubVec.
-    std::vector<std::string> lines{};
-    lines.reserve(dubVec.size());
-
-    // Declare the strings that will hold the coordinates.
-    std::string lineStart = "";
-    std::string lineEnd = "";
-
-    // Declare the pointSlopes that will temporarily hold the coordinates.
-    PointSlope fol; // first of line
-    PointSlope lol; // last of line
+    // Call the function which writes the lines to a file
+    writeFile(dubVec, pointVector, outputFile);
 
-    for (size_t i = 0; i < dubVec.size(); i++) {
-    
-        // First of line is set to the first element of the current line i.
-        fol = dubVec[i][0];
+    // Hand the segments back so that they do not have to be read from file again
+    return lineSegments(dubVec, pointVector);
+}
 
-        // Last of line is set to the last element of the current line i.
-        lol = dubVec[i][dubVec[i].size() - 1];
 
-        // Define lineStart and lineEnd from the coordinates held by fol and lol respectivly.
-        lineStart = std::to_string(fol.point.position.x) + " " + std::to_string(fol.point.position.y) + " ";
-        lineEnd = std::to_string(lol.point.position.x) + " " + std::to_string(lol.point.position.y);
+// Writes the start and end point of every line to a file, one line segment per line: x_1 y_1 x_2 y_2
+void writeFile(const std::vector<Line>& lines, const std::vector<GridPoint>& points,
+               const std::filesystem::path& file) {
+    // Create the output folder, if needed
+    std::error_code ec;
+    if (file.has_parent_path()) std::filesystem::create_directories(file.parent_path(), ec);
 
-        // Save the start and end values.
-        lines.push_back(lineStart + lineEnd);
+    std::ofstream out_file(file);
+    if (!out_file) {
+        throw std::runtime_error(fmt::format("Error opening output file {}", file.string()));
     }
 
-    // Call the function which writes the lines to a file
-    writeFile(lines, pointPath);
- }
-
+    // Write all the lines to the defined file, in large chunks rather than line by line.
+    {
+        BufferedWriter out(out_file);
+        for (const Line& line : lines) {
+            const auto [x1, y1] = points[line.front()];
+            const auto [x2, y2] = points[line.back()];
+            out.print("{:.6f} {:.6f} {:.6f} {:.6f}\n", static_cast<double>(x1), static_cast<double>(y1),
+                      static_cast<double>(x2), static_cast<double>(y2));
+        }
+    }  // the writer flushes the rest here
 
-void writeFile(std::vector<std::string> lines, std::string readFileName) {
-    // File path only suited for Philips computer.
-    std::filesystem::path points_name =
-        "C:/Users/jarja/Documents/TND004/lab 3 part 2/detectionsystem/data/output/segments-" + readFileName;
-    std::cout << points_name << '\n';
-    std::ofstream out_file(points_name);
     if (!out_file) {
-        std::cout << "Error opening output file!!\n";
-        return;
-    }
-
-    // Write all the lines to the defined file.
-    for (size_t i = 0; i < lines.size(); i++) {
-        out_file << lines[i]<< std::endl;
+        throw std::runtime_error(fmt::format("Error writing output file {}", file.string()));
     }
-    // Close file and end the function.
-    out_file.close();
 }
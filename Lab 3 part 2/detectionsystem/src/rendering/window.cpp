@@ -20,6 +20,8 @@
 // all documented so that looking at the source code should not be necessary.
 // Having said that, if you are interested in anything, of course continue browsing here
 
+// Largest number of vertices in a single vertex buffer, larger inputs are split into chunks of this size.
+// Even, so that a chunk never splits the two points of a line
 constexpr size_t vertexBufferObjectCapacity = 1024 * 1024;
 
 // Internal definition of window implementation
@@ -27,12 +29,32 @@ struct rendering::Window::Impl {
     Impl(int width, int height, UseVSync sync);
     ~Impl();
 
+    // Part of the geometry stored on the GPU, at most vertexBufferObjectCapacity vertices
+    struct Chunk {
+        GLuint vao;
+        GLuint vbo;
+        GLsizei count;
+    };
+
+    // Draws count vertices of the vertex array with the program for mode, GL_POINTS or GL_LINES
+    void draw(GLuint vao, GLsizei count, GLenum mode);
+
+    // Uploads points to the streaming buffer and draws them, chunk by chunk
+    void stream(std::span<const Point> points, GLenum mode);
+
     GLFWwindow* window;
 
     GLuint pointProgram;
     GLuint lineProgram;
+    GLint pointSizeScale;
+    GLint lineSizeScale;
+
+    // Streaming buffer, refilled by every drawPoints and drawLines call with a span
     GLuint vao;
     GLuint vbo;
+
+    // Geometry uploaded once by upload(), indexed by Geometry
+    std::vector<std::vector<Chunk>> geometries;
 };
 
 namespace {
@@ -137,13 +159,15 @@ GLuint createPointProgram() {
         layout(location = 1) in vec4  in_color;
         layout(location = 2) in float in_size;
 
+        // Point sizes are relative to the window width
+        uniform float size_scale;
 
         out vec4 vs_color;
 
         void main() {
             vs_color = in_color;
-            gl_PointSize = in_size;
-            gl_Position = vec4(in_position, 0.0, 1.0);
+            gl_PointSize = in_size * size_scale;
+            gl_Position = vec4(2.0 * (in_position - vec2(0.5)), 0.0, 1.0);
         }
     )"};
 
@@ -197,12 +221,14 @@ GLuint createLineProgram() {
         layout(location = 1) in vec4  in_color;
         layout(location = 2) in float in_size;
 
+        uniform float size_scale;
+
         out vec4 vs_color;
         out float vs_width;
         void main() {
             vs_color = in_color;
-            vs_width = in_size;
-            gl_Position = vec4(in_position, 0.0, 1.0);
+            vs_width = in_size * size_scale;
+            gl_Position = vec4(2.0 * (in_position - vec2(0.5)), 0.0, 1.0);
         }
     )"};
 
@@ -295,12 +321,44 @@ GLuint createLineProgram() {
     return program;
 }
 
+/**
+ * Creates a vertex array object that reads Points from the vertex buffer \p vbo
+ *
+ * \param vbo The GL vertex buffer the attributes are read from
+ *
+ * \pre \p vbo must be a valid GL buffer object
+ */
+GLuint createVertexArray(GLuint vbo) {
+    GLuint vao = 0;
+    glGenVertexArrays(1, &vao);
+
+    // Setup vertex attribute pointers for Points
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(rendering::Point),
+                          reinterpret_cast<const void*>(offsetof(rendering::Point, position)));
+
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(rendering::Point),
+                          reinterpret_cast<const void*>(offsetof(rendering::Point, color)));
+
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(rendering::Point),
+                          reinterpret_cast<const void*>(offsetof(rendering::Point, size)));
+
+    glBindVertexArray(0);
+
+    return vao;
+}
+
 }  // namespace
 
 namespace rendering {
 
 Window::Impl::Impl(int width, int height, UseVSync sync)
-    : window{nullptr}, pointProgram{0}, lineProgram{0}, vao{0}, vbo{0} {
+    : window{nullptr}, pointProgram{0}, lineProgram{0}, pointSizeScale{-1}, lineSizeScale{-1}, vao{0}, vbo{0} {
 
     // Initialize GLFW for window handling
     if (glfwInit() != GLFW_TRUE) {
@@ -324,31 +382,16 @@ Window::Impl::Impl(int width, int height, UseVSync sync)
     // Create GL objects
     pointProgram = createPointProgram();
     lineProgram = createLineProgram();
-    glGenVertexArrays(1, &vao);
-    glGenBuffers(1, &vbo);
+    pointSizeScale = glGetUniformLocation(pointProgram, "size_scale");
+    lineSizeScale = glGetUniformLocation(lineProgram, "size_scale");
 
     // Allocate vertex buffer memory
+    glGenBuffers(1, &vbo);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
     glBufferData(GL_ARRAY_BUFFER, vertexBufferObjectCapacity * sizeof(Point), nullptr,
-                 GL_DYNAMIC_DRAW);
-
-    // Setup vertex attribute pointers for Points
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Point),
-                          reinterpret_cast<const void*>(offsetof(Point, position)));
-
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Point),
-                          reinterpret_cast<const void*>(offsetof(Point, color)));
+                 GL_STREAM_DRAW);
 
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(Point),
-                          reinterpret_cast<const void*>(offsetof(Point, size)));
-
-    glBindVertexArray(0);
+    vao = createVertexArray(vbo);
 
     checkOpenGLError("postInit");
 }
@@ -358,6 +401,12 @@ Window::Impl::~Impl() {
     glDeleteProgram(lineProgram);
     glDeleteVertexArrays(1, &vao);
     glDeleteBuffers(1, &vbo);
+    for (const auto& chunks : geometries) {
+        for (const auto& chunk : chunks) {
+            glDeleteVertexArrays(1, &chunk.vao);
+            glDeleteBuffers(1, &chunk.vbo);
+        }
+    }
 
     glfwDestroyWindow(window);
 
@@ -401,67 +450,85 @@ void Window::clear(glm::vec4 color) {
     glClear(GL_COLOR_BUFFER_BIT);
 }
 
-void Window::drawPoints(std::span<const Point> points) {
-    if (points.size() > vertexBufferObjectCapacity) {
-        throw std::runtime_error("Too many lines to draw in a single call");
+void Window::Impl::draw(GLuint array, GLsizei count, GLenum mode) {
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+
+    // Positions are mapped from [0,1] to clip space and sizes are scaled in the vertex shaders,
+    // so the vertex data never has to be rewritten, not even when the window is resized
+    if (mode == GL_POINTS) {
+        glUseProgram(pointProgram);
+        glUniform1f(pointSizeScale, static_cast<float>(width) * 2.0f);
+    } else {
+        glUseProgram(lineProgram);
+        glUniform1f(lineSizeScale, 2.0f);
     }
 
-    int width, height;
-    glfwGetFramebufferSize(impl->window, &width, &height);
+    glBindVertexArray(array);
+    glDrawArrays(mode, 0, count);
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
 
-    // Upload the passed particle information to the GPU
-    glBindBuffer(GL_ARRAY_BUFFER, impl->vbo);
-    Point* point_data = static_cast<Point*>(glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY));
-    if (!point_data) {
-        throw std::runtime_error("Failed to map buffer");
+void Window::Impl::stream(std::span<const Point> points, GLenum mode) {
+    for (size_t first = 0; first < points.size(); first += vertexBufferObjectCapacity) {
+        const auto chunk = points.subspan(first, std::min(vertexBufferObjectCapacity, points.size() - first));
+
+        // Upload the passed particle information to the GPU. Invalidating the buffer lets the driver hand out
+        // fresh memory instead of waiting for the draw of the previous chunk
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        void* data = glMapBufferRange(GL_ARRAY_BUFFER, 0, chunk.size_bytes(),
+                                      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (!data) {
+            throw std::runtime_error("Failed to map buffer");
+        }
+        std::copy(chunk.begin(), chunk.end(), static_cast<Point*>(data));
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+
+        draw(vao, static_cast<GLsizei>(chunk.size()), mode);
     }
+}
 
-    std::transform(points.begin(), points.end(), point_data, [&](const auto& p) -> Point {
-        return {.position = 2.0f * (p.position - glm::vec2{0.5f}),
-                .color = p.color,
-                .size = p.size * width * 2.0f};
-    });
+Window::Geometry Window::upload(std::span<const Point> points) {
+    // Split into chunks, so that no single buffer allocation grows with the input
+    std::vector<Impl::Chunk> chunks;
+    for (size_t first = 0; first < points.size(); first += vertexBufferObjectCapacity) {
+        const auto chunk = points.subspan(first, std::min(vertexBufferObjectCapacity, points.size() - first));
 
-    glUnmapBuffer(GL_ARRAY_BUFFER);
+        GLuint vbo = 0;
+        glGenBuffers(1, &vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, chunk.size_bytes(), chunk.data(), GL_STATIC_DRAW);
 
-    glBindVertexArray(impl->vao);
-    glUseProgram(impl->pointProgram);
-    glDrawArrays(GL_POINTS, 0, static_cast<int>(points.size()));
-    glUseProgram(0);
-    glBindVertexArray(0);
+        chunks.push_back({.vao = createVertexArray(vbo), .vbo = vbo, .count = static_cast<GLsizei>(chunk.size())});
+    }
+    impl->geometries.push_back(std::move(chunks));
+
+    checkOpenGLError("upload");
+    return static_cast<Geometry>(impl->geometries.size() - 1);
+}
 
+void Window::drawPoints(std::span<const Point> points) {
+    impl->stream(points, GL_POINTS);
     checkOpenGLError("drawPoints");
 }
 
-void Window::drawLines(std::span<const Point> lines) {
-    if (lines.size() > vertexBufferObjectCapacity) {
-        throw std::runtime_error("Too many lines to draw in a single call");
+void Window::drawPoints(Geometry points) {
+    for (const auto& chunk : impl->geometries.at(static_cast<size_t>(points))) {
+        impl->draw(chunk.vao, chunk.count, GL_POINTS);
     }
+    checkOpenGLError("drawPoints");
+}
 
-    int width, height;
-    glfwGetFramebufferSize(impl->window, &width, &height);
+void Window::drawLines(std::span<const Point> lines) {
+    impl->stream(lines, GL_LINES);
+    checkOpenGLError("drawLines");
+}
 
-    // Upload the passed particle information to the GPU
-    glBindBuffer(GL_ARRAY_BUFFER, impl->vbo);
-    Point* point_data = static_cast<Point*>(glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY));
-    if (!point_data) {
-        throw std::runtime_error("Failed to map buffer");
+void Window::drawLines(Geometry lines) {
+    for (const auto& chunk : impl->geometries.at(static_cast<size_t>(lines))) {
+        impl->draw(chunk.vao, chunk.count, GL_LINES);
     }
-
-    std::transform(lines.begin(), lines.end(), point_data, [&](const auto& p) -> Point {
-        return {.position = 2.0f * (p.position - glm::vec2{0.5f}),
-                .color = p.color,
-                .size = p.size * 2.0f};
-    });
-
-    glUnmapBuffer(GL_ARRAY_BUFFER);
-
-    glBindVertexArray(impl->vao);
-    glUseProgram(impl->lineProgram);
-    glDrawArrays(GL_LINES, 0, static_cast<int>(lines.size()));
-    glUseProgram(0);
-    glBindVertexArray(0);
-
     checkOpenGLError("drawLines");
 }
 
@@ -0,0 +1,154 @@
+/*********************************************
+ * file:	~\code4a\bench.cpp                *
+ * remark: delta-stepping vs Dijkstra         *
+ **********************************************/
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <cstdlib>  // std::atoi, std::atoll
+#include <vector>
+#include <chrono>
+#include <random>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <format>
+
+#include "digraph.h"
+
+/*
+ * Benchmark of the parallel delta-stepping search of pwtree against Dijkstra's algorithm
+ *
+ * Usage: Lab4aBench [--edges <m1,m2,...>] [--degree <d>] [--weights <w>] [--delta <d1,d2,...>]
+ *                   [--threads <t>] [--sources <k>] [--seed <s>]
+ *   --edges    number of edges of every generated graph, default 1000000,3000000,10000000
+ *   --degree   average out-degree, the graph has edges / degree vertices, default 8
+ *   --weights  edge weights are drawn uniformly from 1..w, default 100
+ *   --delta    bucket widths to run, 0 picks one from the graph, default 0, pwtree raises tiny widths
+ *   --threads  threads used by delta-stepping, default one per hardware thread
+ *   --sources  number of random start vertices per graph, default 5
+ *
+ * Every graph is random with uniformly chosen end points. The times are averaged over the start vertices,
+ * every delta-stepping tree is checked against the distances of Dijkstra's algorithm.
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::vector<long long> edges{1'000'000, 3'000'000, 10'000'000};
+    int degree = 8;
+    int weights = 100;
+    std::vector<long long> delta{0};
+    unsigned threads = 0;
+    int sources = 5;
+    unsigned long long seed = 2024;
+};
+
+std::vector<long long> parseList(std::string_view list) {
+    std::vector<long long> values;
+    while (!list.empty()) {
+        const auto comma = list.find(',');
+        values.push_back(std::atoll(std::string{list.substr(0, comma)}.c_str()));
+        list = (comma == std::string_view::npos) ? std::string_view{} : list.substr(comma + 1);
+    }
+    return values;
+}
+
+Options parseArguments(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--edges" && hasValue) {
+            options.edges = parseList(argv[++i]);
+            std::erase_if(options.edges, [](long long m) { return m <= 0; });
+        } else if (arg == "--degree" && hasValue) {
+            options.degree = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "--weights" && hasValue) {
+            options.weights = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "--delta" && hasValue) {
+            options.delta = parseList(argv[++i]);
+            std::erase_if(options.delta, [](long long d) { return d < 0; });
+        } else if (arg == "--threads" && hasValue) {
+            options.threads = static_cast<unsigned>(std::max(std::atoi(argv[++i]), 0));
+        } else if (arg == "--sources" && hasValue) {
+            options.sources = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = static_cast<unsigned long long>(std::atoll(argv[++i]));
+        } else {
+            throw std::runtime_error(std::format("unknown option {}", arg));
+        }
+    }
+    return options;
+}
+
+// m random edges between n vertices, without self loops
+std::vector<Edge> generateEdges(int n, long long m, int weights, std::mt19937_64& random) {
+    std::uniform_int_distribution<int> vertex(1, n);
+    std::uniform_int_distribution<int> weight(1, weights);
+
+    std::vector<Edge> V;
+    V.reserve(m);
+    while (std::ssize(V) < m) {
+        const int u = vertex(random);
+        const int v = vertex(random);
+        if (u != v) V.emplace_back(u, v, weight(random));
+    }
+    return V;
+}
+
+double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+}  // namespace
+
+/* ************************************* */
+
+int main(int argc, char* argv[]) try {
+    const Options options = parseArguments(argc, argv);
+    std::mt19937_64 random(options.seed);
+
+    std::cout << std::format("{:>10} {:>9} {:>7} {:>12} {:>14} {:>8} {:>6}\n", "edges", "vertices", "delta",
+                             "dijkstra_ms", "deltastep_ms", "speedup", "check");
+
+    for (long long m : options.edges) {
+        const int n = static_cast<int>(std::max(m / options.degree, 2LL));
+        const Digraph G{generateEdges(n, m, options.weights, random), n};
+
+        std::uniform_int_distribution<int> vertex(1, n);
+        std::vector<int> sources(options.sources);
+        for (auto& s : sources) s = vertex(random);
+
+        // The first query builds the adjacency of G, it is not timed
+        G.pwtree(sources[0], 1);
+
+        double dijkstra_ms = 0.0;
+        std::vector<PathTree> reference;
+        for (int s : sources) {
+            const auto start = Clock::now();
+            reference.push_back(G.pwtree(s, 1));
+            dijkstra_ms += millisecondsSince(start) / sources.size();
+        }
+
+        for (long long delta : options.delta) {
+            double deltastep_ms = 0.0;
+            bool same = true;
+            for (std::size_t k = 0; k < sources.size(); ++k) {
+                const auto start = Clock::now();
+                const PathTree T = G.pwtree(sources[k], options.threads, static_cast<int>(delta));
+                deltastep_ms += millisecondsSince(start) / sources.size();
+                same = same && (T.dist == reference[k].dist);
+            }
+            std::cout << std::format("{:>10} {:>9} {:>7} {:>12.2f} {:>14.2f} {:>8.2f} {:>6}\n", m, n,
+                                     (delta == 0) ? std::string{"auto"} : std::to_string(delta), dijkstra_ms,
+                                     deltastep_ms, dijkstra_ms / deltastep_ms, same ? "ok" : "FAIL");
+        }
+    }
+} catch (const std::exception& e) {
+    std::cout << std::format("Error: {}\n", e.what());
+    return 1;
+}
@@ -0,0 +1,98 @@
+/*********************************************
+ * file:	~\code4a\convert.cpp              *
+ * remark: text to binary graph files         *
+ **********************************************/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <charconv>  // std::from_chars
+#include <cctype>    // std::isspace
+#include <stdexcept>
+#include <format>
+
+#include "edge.h"
+#include "graphfile.h"
+
+/*
+ * Converts a graph file in the text format read by readGraph (the number of vertices, then one "u v w"
+ * triple per edge) into a binary graph file, see graphfile.h
+ *
+ * Usage: Lab4Convert [--undirected] <text file> <binary file>
+ *        Lab4Convert --verify <binary file>
+ *   --undirected  the graph is undirected as in part B, every edge is stored in both directions
+ *   --verify      check every edge of a binary graph file, which readGraph does not do (see verifyGraphFile)
+ *
+ * readGraph maps files ending in .csr, so the binary file should be given that extension.
+ */
+
+namespace {
+
+// All numbers in text, separated by white space
+std::vector<int> parseNumbers(std::string_view text) {
+    std::vector<int> numbers;
+    const char* p = text.data();
+    const char* end = text.data() + text.size();
+    while (true) {
+        while (p != end && std::isspace(static_cast<unsigned char>(*p))) ++p;
+        if (p == end) break;
+
+        int value = 0;
+        auto [next, error] = std::from_chars(p, end, value);
+        if (error != std::errc{}) throw std::runtime_error("the text file holds something that is not a number");
+        numbers.push_back(value);
+        p = next;
+    }
+    return numbers;
+}
+
+}  // namespace
+
+/* ************************************* */
+
+int main(int argc, char* argv[]) try {
+    std::vector<std::string_view> args(argv + 1, argv + argc);
+    if (args.size() == 2 && args.front() == "--verify") {
+        const CSR G = verifyGraphFile(std::string{args[1]});
+        std::cout << std::format("{}: {} vertices, {} edges, ok\n", args[1], std::ssize(G.offsets) - 2, G.edges());
+        return 0;
+    }
+
+    const bool undirected = !args.empty() && args.front() == "--undirected";
+    if (undirected) args.erase(args.begin());
+    if (args.size() != 2) {
+        std::cout << "Usage: Lab4Convert [--undirected] <text file> <binary file>\n"
+                     "       Lab4Convert --verify <binary file>\n";
+        return 1;
+    }
+
+    std::ifstream in{std::string{args[0]}};
+    if (!in) throw std::runtime_error(std::format("can not read {}", args[0]));
+    std::stringstream text;
+    text << in.rdbuf();
+
+    const std::vector<int> numbers = parseNumbers(text.view());
+    if (numbers.empty() || numbers[0] < 1 || (numbers.size() - 1) % 3 != 0) {
+        throw std::runtime_error(std::format("{} is not a graph file", args[0]));
+    }
+
+    // The edges as the constructors of Digraph and Graph receive them
+    const int n = numbers[0];
+    std::vector<Edge> E;
+    E.reserve((undirected ? 2 : 1) * (numbers.size() - 1) / 3);
+    for (std::size_t i = 1; i < numbers.size(); i += 3) {
+        const Edge e{numbers[i], numbers[i + 1], numbers[i + 2]};
+        E.push_back(e);
+        if (undirected) E.push_back(e.reverse());
+    }
+
+    const CSR G = fileAdjacency(E, n);
+    writeGraphFile(std::string{args[1]}, G);
+    std::cout << std::format("{}: {} vertices, {} edges\n", args[1], n, G.edges());
+} catch (const std::exception& e) {
+    std::cout << std::format("Error: {}\n", e.what());
+    return 1;
+}
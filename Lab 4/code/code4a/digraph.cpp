@@ -9,75 +9,235 @@
 #include <vector>
 #include <cassert>
 #include <queue>
+#include <utility>     //std::pair
+#include <functional>  //std::greater
+#include <iterator>    //std::prev
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <barrier>
+#include <bit>      //std::countr_zero
+#include <cstdint>  //std::uint64_t
 #include <format>
 
 #include "digraph.h"
 
 // Note: graph vertices are numbered from 1 -- i.e. there is no vertex zero
 
+namespace {
+
+// number of threads to use, 0 threads is all hardware threads
+unsigned workerCount(unsigned threads) {
+    return (threads == 0) ? std::max(1u, std::thread::hardware_concurrency()) : threads;
+}
+
+// Answers queries 0, ..., count - 1 with query(i) on a pool of threads, 0 threads uses all hardware threads
+template <typename Query>
+std::vector<PathResult> runBatch(std::size_t count, unsigned threads, Query query) {
+    threads = static_cast<unsigned>(std::min<std::size_t>(workerCount(threads), std::max<std::size_t>(count, 1)));
+
+    // Queries take very different times, so every thread takes the next unanswered query
+    std::vector<PathResult> results(count);
+    std::atomic<std::size_t> next{0};
+    auto work = [&] {
+        for (std::size_t i = next++; i < count; i = next++) {
+            results[i] = query(i);
+        }
+    };
+
+    std::vector<std::jthread> pool;
+    for (unsigned k = 1; k < threads; ++k) {
+        pool.emplace_back(work);
+    }
+    work();
+    return results;  // the pool joins before results is returned
+}
+
+// unique id of every graph, 0 is never used
+unsigned long long nextId() {
+    static std::atomic<unsigned long long> counter{0};
+    return ++counter;
+}
+
+// workspaces of the calling thread, one per kind of search, shared by all graphs
+Workspace& threadWorkspace(int search) {
+    thread_local Workspace workspaces[3];
+    return workspaces[search];
+}
+
+}  // namespace
+
 // -- CONSTRUCTORS
 
 Digraph::Digraph(int n)
     : table(n + 1)  // slot zero not used
     , size{n}       // number of verices
     , n_edges{0}
-    , dist(n + 1)
-    , path(n + 1)
-    , done(n + 1) {
+    , id{nextId()} {
     assert(n >= 1);
     // Note: graph vertices are numbered from 1 -- i.e. there is no vertex zero
 }
 
 // Create a digraph with n vertices and the edges in V
-Digraph::Digraph(const std::vector<Edge>& V, int n) : Digraph{n} {
-    for (auto e : V) {
-        insertEdge(e);
+Digraph::Digraph(const std::vector<Edge>& V, int n, bool useEdgeIndex) : Digraph{n} {
+    use_edge_index = useEdgeIndex;
+
+    // Repeated edges are removed up front, so that no edge has to be searched for
+    for (auto const& e : uniqueEdges(V)) {
+        assert(e.from >= 1 && e.from <= size);
+        assert(e.to >= 1 && e.to <= size);
+
+        table[e.from].push_back(e);
+        if (use_edge_index) edge_index.emplace(edgeKey(e.from, e.to), std::prev(end(table[e.from])));
+        ++n_edges;
     }
 }
 
+// Create a digraph with the given adjacency
+Digraph::Digraph(CSR G, bool useEdgeIndex) : Digraph{static_cast<int>(G.offsets.size()) - 2} {
+    use_edge_index = useEdgeIndex;
+    has_table = false;
+    n_edges = G.edges();
+    csr = std::move(G);
+    csr_dirty = false;
+}
+
 // -- MEMBER FUNCTIONS
 
+// fill table from csr, if the digraph was created from an adjacency
+void Digraph::buildTable() {
+    if (has_table) return;
+
+    for (int v = 1; v <= size; ++v) {
+        for (int i = csr.first(v); i < csr.last(v); ++i) {
+            table[v].push_back({v, csr.targets[i], csr.weights[i]});
+            if (use_edge_index) edge_index.emplace(edgeKey(v, csr.targets[i]), std::prev(end(table[v])));
+        }
+    }
+    has_table = true;
+}
+
 // insert directed edge e = (u, v, w)
 // update weight w if edge (u, v) is present
 void Digraph::insertEdge(const Edge& e) {
     assert(e.from >= 1 && e.from <= size);
     assert(e.to >= 1 && e.to <= size);
+    buildTable();
 
     // Check if edge e already exists
-    if (auto it = std::find_if(begin(table[e.from]), end(table[e.from]),
-                               [e](const Edge& ed) { return e.links_same_nodes(ed); });
-        it == end(table[e.from])) {
+    if (auto it = findEdge(e.from, e.to); it == end(table[e.from])) {
         table[e.from].push_back(e);  // insert new edge e
+        if (use_edge_index) edge_index.emplace(edgeKey(e.from, e.to), std::prev(end(table[e.from])));
         ++n_edges;
     } else {
         it->weight = e.weight;  // update the weight
     }
+    csr_dirty = reverse_csr_dirty = true;
 }
 
 // remove directed edge e
 void Digraph::removeEdge(const Edge& e) {
     assert(e.from >= 1 && e.from <= size);
     assert(e.to >= 1 && e.to <= size);
+    buildTable();
 
-    auto it = std::find_if(begin(table[e.from]), end(table[e.from]),
-                           [e](const Edge& ed) { return e.links_same_nodes(ed); });
+    auto it = findEdge(e.from, e.to);
 
     assert(it != end(table[e.from]));
+    if (use_edge_index) edge_index.erase(edgeKey(e.from, e.to));
     table[e.from].erase(it);
     --n_edges;
+    csr_dirty = reverse_csr_dirty = true;
+}
+
+// edge (u, v) in table[u], or end(table[u]) if there is no such edge
+std::list<Edge>::iterator Digraph::findEdge(int u, int v) {
+    if (use_edge_index) {
+        auto it = edge_index.find(edgeKey(u, v));
+        return (it == edge_index.end()) ? end(table[u]) : it->second;
+    }
+    return std::find_if(begin(table[u]), end(table[u]), [v](const Edge& ed) { return ed.to == v; });
+}
+
+// flat copy of table used by the queries, rebuilt after the graph was modified
+// Once built, the queries only read the flag, the mutex is taken by the thread that rebuilds it
+const CSR& Digraph::adjacency() const {
+    if (csr_dirty.load(std::memory_order_acquire)) {
+        std::lock_guard lock{csr_mutex};
+        if (csr_dirty.load(std::memory_order_relaxed)) {
+            csr = CSR{table};
+            csr_dirty.store(false, std::memory_order_release);
+        }
+    }
+    return csr;
+}
+
+// the same with all edges reversed, used by the backward search of uwpath and pwpath
+const CSR& Digraph::reverseAdjacency() const {
+    const CSR& G = adjacency();
+
+    if (reverse_csr_dirty.load(std::memory_order_acquire)) {
+        std::lock_guard lock{csr_mutex};
+        if (reverse_csr_dirty.load(std::memory_order_relaxed)) {
+            reverse_csr = G.reversed(&reverse_edge);
+            reverse_csr_dirty.store(false, std::memory_order_release);
+        }
+    }
+    return reverse_csr;
+}
+
+// workspace of the calling thread for the given search, reset for a search on this graph
+Workspace& Digraph::workspace(Search search) const {
+    Workspace& W = threadWorkspace(static_cast<int>(search));
+    W.reset(size);
+    W.owner = id;
+    return W;
+}
+
+// workspace holding the tree of the last uwsssp or pwsssp call on this graph by the calling thread,
+// nullptr if there is none
+const Workspace* Digraph::tree() const {
+    const Workspace& W = threadWorkspace(static_cast<int>(Search::Tree));
+    return (W.owner == id) ? &W : nullptr;
 }
 
 // construct unweighted single source shortest path-tree for start vertex s
-void Digraph::uwsssp(int s) const {
+void Digraph::uwsssp(int s, unsigned threads) const {
+    assert(s >= 1 && s <= size);
+
+    uwsearch(s, Search::Tree, threads);
+}
+
+// construct positive weighted single source shortest path-tree for start vertex s
+// Dijkstra's algorithm
+void Digraph::pwsssp(int s, unsigned threads, int delta) const {
     assert(s >= 1 && s <= size);
 
+    pwsearch(s, Search::Tree, threads, delta);
+}
+
+// unweighted single source shortest path-tree for start vertex s
+PathTree Digraph::uwtree(int s, unsigned threads) const {
+    assert(s >= 1 && s <= size);
+    return toTree(uwsearch(s, Search::Forward, threads));
+}
+
+// positive weighted single source shortest path-tree for start vertex s
+PathTree Digraph::pwtree(int s, unsigned threads, int delta) const {
+    assert(s >= 1 && s <= size);
+    assert(delta >= 0);
+    return toTree(pwsearch(s, Search::Forward, threads, delta));
+}
+
+// BFS from s into the given workspace of the calling thread
+const Workspace& Digraph::uwsearch(int s, Search search) const {
     // *** TODO ***
-    // dist vector should be initialized with std::numeric_limits<int>::max()
-    for (int i = 0; i <= size; i++) {
-        dist[i] = std::numeric_limits<int>::max();
-        path[i] = 0;
-    }
-    dist[s] = 0;
+    // all distances start at Workspace::infinity, only the reached vertices are written
+    Workspace& W = workspace(search);
+    W.source = s;
+    W.set(s, 0, 0);
+
+    const CSR& G = adjacency();
 
     std::queue<int> Q;
     Q.push(s);
@@ -86,63 +246,622 @@ void Digraph::uwsssp(int s) const {
         int v = Q.front();
         Q.pop();
 
-        for (auto& e : table[v]) {
-            int u = e.to;
+        for (int i = G.first(v); i < G.last(v); ++i) {
+            int u = G.targets[i];
 
-            if (dist[u] == std::numeric_limits<int>::max()) {
-                dist[u] = dist[v] + 1;
-                path[u] = v;
+            if (W.dist(u) == Workspace::infinity) {
+                W.set(u, W.dist(v) + 1, v);
                 Q.push(u);
             }
         }
     }
-    std::cout << "\n";
-    printTree();
+    return W;
 }
 
-// construct positive weighted single source shortest path-tree for start vertex s
-// Dijktras algorithm
-void Digraph::pwsssp(int s) const {
+namespace {
+
+// Graphs with fewer edges are searched by one thread, starting the threads costs more than they save
+constexpr int parallel_min_edges = 1 << 16;
+
+// Largest number of distance buckets of delta-stepping, delta is raised for heavier edges
+constexpr int max_buckets = 1 << 16;
+
+// Direction switching thresholds of the parallel BFS, the values suggested by Beamer et al.
+constexpr long long bottom_up_alpha = 14;  // go bottom-up when the frontier has more than 1/alpha of the unvisited edges
+constexpr long long bottom_up_beta = 24;   // go back top-down when the frontier has less than 1/beta of the vertices
+
+// Sets of vertices, one bit per vertex, that threads may add to at the same time
+using Bitmap = std::vector<std::atomic<std::uint64_t>>;
+
+bool contains(const Bitmap& B, int v) {
+    return (B[v / 64].load(std::memory_order_relaxed) >> (v % 64)) & 1;
+}
+
+void insert(Bitmap& B, int v) {
+    B[v / 64].fetch_or(std::uint64_t{1} << (v % 64), std::memory_order_relaxed);
+}
+
+}  // namespace
+
+// Level synchronous parallel BFS from s, direction optimizing as described by Beamer et al.
+// While the frontier is small a level is expanded top-down: the frontier vertices are split among the threads,
+// which claim the unvisited vertices along the edges. Once the edges leaving the frontier are a large part of
+// the edges still to be checked, every unvisited vertex instead looks for a parent in the frontier bitmap along
+// its reversed edges (bottom-up), until the frontier is small again.
+// The sequential BFS gives every vertex the parent whose edge it meets first, so each vertex keeps the smallest
+// key (queue position of the parent, index of the edge) it is reached by, and the vertices of a level are sorted
+// by that key before the next level starts. The bottom-up step therefore checks all reversed edges of a vertex.
+const Workspace& Digraph::uwsearch(int s, Search search, unsigned threads) const {
+    const CSR& G = adjacency();
+    threads = workerCount(threads);
+    if (threads == 1 || G.edges() < parallel_min_edges) {
+        return uwsearch(s, search);
+    }
+
+    const CSR& R = reverseAdjacency();
+    Workspace& W = workspace(search);
+    W.source = s;
+
+    using Key = std::uint64_t;
+    constexpr Key unset = std::numeric_limits<Key>::max();
+    auto makeKey = [](int position, int edge) { return (Key(position) << 32) | Key(unsigned(edge)); };
+
+    std::vector<std::atomic<Key>> key(size + 1);  // key of the edge a vertex was reached by
+    for (auto& k : key) {
+        k.store(unset, std::memory_order_relaxed);
+    }
+
+    // Vertex zero and the bits past the last vertex count as visited, so that they are never searched
+    const int words = size / 64 + 1;
+    Bitmap visited(words);
+    Bitmap frontier(words);  // only filled for bottom-up levels
+    insert(visited, 0);
+    for (int v = size + 1; v < 64 * words; ++v) {
+        insert(visited, v);
+    }
+
+    // Vertices in BFS order, level d is queue[level_start[d]], ..., queue[level_start[d + 1] - 1]
+    std::vector<int> queue(size);
+    std::vector<int> position(size + 1);  // position of every visited vertex in queue
+    std::vector<int> level_start{0, 1};
+    queue[0] = s;
+    position[s] = 0;
+    insert(visited, s);
+
+    std::vector<std::vector<int>> found(threads);  // vertices reached by each thread on the current level
+    std::atomic<long long> found_edges{0};          // edges leaving them
+    long long unvisited_edges = G.edges() - G.degree(s);
+    bool top_down = true;
+    bool finished = false;
+
+    // Threads take the next chunk of work until there is none left
+    std::atomic<std::size_t> next{0};
+    auto chunks = [&next](std::size_t count, std::size_t chunk, auto body) {
+        for (std::size_t lo = next.fetch_add(chunk); lo < count; lo = next.fetch_add(chunk)) {
+            body(lo, std::min(lo + chunk, count));
+        }
+    };
+
+    auto byKey = [&key](int u, int v) {
+        return key[u].load(std::memory_order_relaxed) < key[v].load(std::memory_order_relaxed);
+    };
+
+    // Every level takes three phases: reach the next level, sort it, and add it to queue and the bitmaps
+    // Between two phases one thread runs step() while all others wait
+    int phase = 0;
+    auto step = [&]() noexcept {
+        if (phase == 0) {
+            finished = std::all_of(found.begin(), found.end(), [](const auto& f) { return f.empty(); });
+            if (!top_down) {
+                for (auto& w : frontier) w.store(0, std::memory_order_relaxed);
+            }
+        } else if (phase == 1) {
+            // Merge the sorted vertices of all threads into queue order
+            std::vector<int> runs{level_start.back()};
+            for (auto& f : found) {
+                std::copy(f.begin(), f.end(), queue.begin() + runs.back());
+                runs.push_back(runs.back() + static_cast<int>(f.size()));
+                f.clear();
+            }
+            const std::size_t n_runs = runs.size() - 1;
+            for (std::size_t width = 1; width < n_runs; width *= 2) {
+                for (std::size_t r = 0; r + width < n_runs; r += 2 * width) {
+                    std::inplace_merge(queue.begin() + runs[r], queue.begin() + runs[r + width],
+                                       queue.begin() + runs[std::min(r + 2 * width, n_runs)], byKey);
+                }
+            }
+            level_start.push_back(runs.back());
+
+            // Direction of the next level
+            const long long frontier_edges = found_edges.exchange(0);
+            const long long frontier_vertices = runs.back() - runs.front();
+            unvisited_edges -= frontier_edges;
+            if (top_down) {
+                top_down = frontier_edges <= unvisited_edges / bottom_up_alpha;
+            } else {
+                top_down = frontier_vertices < size / bottom_up_beta;
+            }
+        }
+        phase = (phase + 1) % 3;
+        next = 0;
+    };
+    std::barrier sync(static_cast<std::ptrdiff_t>(threads), step);
+
+    auto work = [&](unsigned thread) {
+        std::vector<int>& mine = found[thread];
+        while (true) {
+            const int lo = level_start[level_start.size() - 2];
+            const int hi = level_start.back();
+            long long edges = 0;
+
+            if (top_down) {
+                // Every unvisited vertex keeps the smallest key it is reached by, the thread that reaches
+                // it first adds it to the level
+                chunks(hi - lo, 256, [&](std::size_t a, std::size_t b) {
+                    for (int q = lo + static_cast<int>(a); q < lo + static_cast<int>(b); ++q) {
+                        const int v = queue[q];
+                        for (int i = G.first(v); i < G.last(v); ++i) {
+                            const int u = G.targets[i];
+                            if (contains(visited, u)) continue;
+
+                            const Key k = makeKey(q, i);
+                            Key old = key[u].load(std::memory_order_relaxed);
+                            while (k < old && !key[u].compare_exchange_weak(old, k, std::memory_order_relaxed)) {
+                            }
+                            if (old == unset) {
+                                mine.push_back(u);
+                                edges += G.degree(u);
+                            }
+                        }
+                    }
+                });
+            } else {
+                // Every unvisited vertex looks for its parent in the frontier, 64 vertices per word
+                chunks(static_cast<std::size_t>(words), 16, [&](std::size_t a, std::size_t b) {
+                    for (std::size_t w = a; w < b; ++w) {
+                        for (auto bits = ~visited[w].load(std::memory_order_relaxed); bits != 0; bits &= bits - 1) {
+                            const int u = static_cast<int>(64 * w) + std::countr_zero(bits);
+
+                            Key best = unset;
+                            for (int j = R.first(u); j < R.last(u); ++j) {
+                                const int v = R.targets[j];
+                                if (contains(frontier, v)) {
+                                    best = std::min(best, makeKey(position[v], reverse_edge[j]));
+                                }
+                            }
+                            if (best != unset) {
+                                key[u].store(best, std::memory_order_relaxed);
+                                mine.push_back(u);
+                                edges += G.degree(u);
+                            }
+                        }
+                    }
+                });
+            }
+            found_edges += edges;
+
+            sync.arrive_and_wait();
+            if (finished) break;
+
+            std::sort(mine.begin(), mine.end(), byKey);
+            sync.arrive_and_wait();
+
+            const int first = level_start[level_start.size() - 2];
+            const int last = level_start.back();
+            chunks(last - first, 4096, [&](std::size_t a, std::size_t b) {
+                for (int q = first + static_cast<int>(a); q < first + static_cast<int>(b); ++q) {
+                    const int u = queue[q];
+                    position[u] = q;
+                    insert(visited, u);
+                    if (!top_down) insert(frontier, u);
+                }
+            });
+            sync.arrive_and_wait();
+        }
+
+        // Write the tree, the parent of a vertex is the start of the edge it was reached by
+        chunks(static_cast<std::size_t>(level_start.back()), 4096, [&](std::size_t a, std::size_t b) {
+            int d = static_cast<int>(std::upper_bound(level_start.begin(), level_start.end(), static_cast<int>(a)) -
+                                     level_start.begin()) - 1;
+            for (int q = static_cast<int>(a); q < static_cast<int>(b); ++q) {
+                while (q >= level_start[d + 1]) ++d;
+                const int u = queue[q];
+                W.set(u, d, (q == 0) ? 0 : queue[key[u].load(std::memory_order_relaxed) >> 32]);
+            }
+        });
+    };
+
+    std::vector<std::jthread> pool;
+    for (unsigned thread = 1; thread < threads; ++thread) {
+        pool.emplace_back(work, thread);
+    }
+    work(0);
+    return W;  // the pool joins before W is returned
+}
+
+// Dijkstra's algorithm with a binary heap from s into the given workspace of the calling thread, O((V+E) log V)
+// Of several shortest paths to a vertex the one through the smallest previous vertex is kept, as by delta-stepping
+const Workspace& Digraph::pwsearch(int s, Search search) const {
+    // all distances start at Workspace::infinity, only the reached vertices are written
+    Workspace& W = workspace(search);
+    W.source = s;
+    W.set(s, 0, 0);
+
+    const CSR& G = adjacency();
+
+    // Vertices ordered by their tentative distance, smallest first
+    // A vertex is pushed again when its distance drops, the outdated entries are skipped when popped
+    using Entry = std::pair<int, int>;  // (dist, vertex)
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> Q;
+    Q.push({0, s});
+
+    while (!Q.empty()) {
+        auto [d, v] = Q.top();
+        Q.pop();
+
+        if (W.done(v)) continue;
+        W.setDone(v);
+
+        for (int i = G.first(v); i < G.last(v); ++i) {
+            int u = G.targets[i];
+
+            if (W.done(u) == false && W.dist(u) > d + G.weights[i]) {
+                W.set(u, d + G.weights[i], v);
+                Q.push({W.dist(u), u});
+            } else if (W.done(u) == false && W.dist(u) == d + G.weights[i] && v < W.path(u)) {
+                W.set(u, W.dist(u), v);  // the same distance, the entry in Q is still valid
+            }
+        }
+    }
+    return W;
+}
+
+// Delta-stepping (Meyer and Sanders) from s on the given number of threads
+// The reached vertices are kept in buckets of distances [i * delta, (i + 1) * delta). The buckets are emptied in
+// order: the light edges (weight <= delta) of the vertices in the current bucket are relaxed in parallel, which may
+// put vertices back into the same bucket, until it stays empty. The distances in it are then final, and the heavy
+// edges of its vertices, which can only reach later buckets, are relaxed once.
+// An edge reaches at most max_weight past the current bucket, so all reached vertices are in the next
+// max_weight / delta + 2 buckets, which are kept in a cyclic array.
+// Distance and previous vertex of every vertex are packed into one word and lowered together, so that of several
+// shortest paths the one through the smallest previous vertex wins, no matter in which order the threads run.
+const Workspace& Digraph::pwsearch(int s, Search search, unsigned threads, int delta) const {
+    const CSR& G = adjacency();
+    threads = workerCount(threads);
+    if (threads == 1 || G.edges() < parallel_min_edges) {
+        return pwsearch(s, search);
+    }
+
+    const int max_weight = *std::max_element(G.weights.begin(), G.weights.end());
+    if (delta == 0) {
+        // The heaviest edge spread over the average degree, about the choice Meyer and Sanders suggest
+        delta = std::max(1, max_weight / std::max(1, G.edges() / size));
+    }
+    delta = std::max(delta, max_weight / max_buckets);  // at most max_buckets + 2 buckets
+    const std::size_t cycle = static_cast<std::size_t>(max_weight / delta) + 2;
+
+    Workspace& W = workspace(search);
+    W.source = s;
+
+    using Key = std::uint64_t;  // (distance, previous vertex)
+    constexpr Key unset = std::numeric_limits<Key>::max();
+    auto makeKey = [](int dist, int v) { return (Key(unsigned(dist)) << 32) | Key(unsigned(v)); };
+    auto distOf = [](Key k) { return static_cast<int>(k >> 32); };
+
+    std::vector<std::atomic<Key>> key(size + 1);
+    for (auto& k : key) {
+        k.store(unset, std::memory_order_relaxed);
+    }
+    key[s].store(makeKey(0, 0), std::memory_order_relaxed);
+
+    // Every thread puts the vertices it reaches into its own buckets, bucket[thread][i % cycle] holds the pairs
+    // (vertex, distance) with distances in bucket i, a pair is outdated once the distance of the vertex dropped
+    using Entry = std::pair<int, int>;
+    std::vector<std::vector<std::vector<Entry>>> bucket(threads, std::vector<std::vector<Entry>>(cycle));
+    std::vector<std::vector<Entry>> settled(threads);  // vertices taken from the current bucket by each thread
+    bucket[0][0].push_back({s, 0});
+
+    std::vector<Entry> current;  // the vertices of the current bucket, relaxed in this round
+    std::size_t i = 0;           // index of the current bucket, not wrapped
+    bool light = true;           // relaxing the light edges of bucket i, else the heavy ones
+    bool finished = false;
+
+    // Threads take the next chunk of work until there is none left
+    std::atomic<std::size_t> next{0};
+
+    // Between two rounds one thread runs step() while all others wait
+    auto step = [&]() noexcept {
+        if (!light) {
+            // The heavy edges of bucket i are relaxed, continue with the first bucket that is not empty
+            auto empty = [&](std::size_t j) {
+                return std::all_of(bucket.begin(), bucket.end(), [j](const auto& b) { return b[j].empty(); });
+            };
+            std::size_t k = 1;
+            while (k < cycle && empty((i + k) % cycle)) {
+                ++k;
+            }
+            finished = (k == cycle);
+            i += k;
+            light = true;
+        }
+
+        current.clear();
+        for (auto& b : bucket) {
+            auto& entries = b[i % cycle];
+            current.insert(current.end(), entries.begin(), entries.end());
+            entries.clear();
+        }
+        light = !current.empty();
+        next = 0;
+    };
+    std::barrier sync(static_cast<std::ptrdiff_t>(threads), step);
+
+    auto work = [&](unsigned thread) {
+        auto& mine = bucket[thread];
+
+        // Lower the distance of the end vertex of edge e leaving v, d is the distance of v
+        auto relax = [&](int v, int d, int e) {
+            const int u = G.targets[e];
+            const int du = d + G.weights[e];
+            const Key k = makeKey(du, v);
+
+            Key old = key[u].load(std::memory_order_relaxed);
+            while (k < old && !key[u].compare_exchange_weak(old, k, std::memory_order_relaxed)) {
+            }
+            if ((k >> 32) < (old >> 32)) {  // the distance dropped, not only the previous vertex
+                mine[static_cast<std::size_t>(du / delta) % cycle].push_back({u, du});
+            }
+        };
+        auto current_dist = [&](int v) { return distOf(key[v].load(std::memory_order_relaxed)); };
+
+        sync.arrive_and_wait();
+        while (!finished) {
+            if (light) {
+                for (std::size_t lo = next.fetch_add(256); lo < current.size(); lo = next.fetch_add(256)) {
+                    for (std::size_t k = lo; k < std::min(lo + 256, current.size()); ++k) {
+                        auto [v, d] = current[k];
+                        if (current_dist(v) != d) continue;  // outdated
+
+                        settled[thread].push_back({v, d});
+                        for (int e = G.first(v); e < G.last(v); ++e) {
+                            if (G.weights[e] <= delta) relax(v, d, e);
+                        }
+                    }
+                }
+            } else {
+                for (auto [v, d] : settled[thread]) {
+                    if (current_dist(v) != d) continue;  // relaxed again later with a smaller distance
+                    for (int e = G.first(v); e < G.last(v); ++e) {
+                        if (G.weights[e] > delta) relax(v, d, e);
+                    }
+                }
+                settled[thread].clear();
+            }
+            sync.arrive_and_wait();
+        }
+
+        // Write the tree
+        for (std::size_t lo = next.fetch_add(4096); lo <= static_cast<std::size_t>(size); lo = next.fetch_add(4096)) {
+            for (int v = std::max(1, static_cast<int>(lo)); v <= std::min(size, static_cast<int>(lo + 4095)); ++v) {
+                const Key k = key[v].load(std::memory_order_relaxed);
+                if (k != unset) W.set(v, distOf(k), static_cast<int>(k & 0xffffffff));
+            }
+        }
+    };
+
+    std::vector<std::jthread> pool;
+    for (unsigned thread = 1; thread < threads; ++thread) {
+        pool.emplace_back(work, thread);
+    }
+    work(0);
+    return W;  // the pool joins before W is returned
+}
+
+// copy of the tree in W
+PathTree Digraph::toTree(const Workspace& W) const {
+    PathTree T{W.source, std::vector<int>(size + 1, -1), std::vector<int>(size + 1, 0)};
+    for (int v = 1; v <= size; ++v) {
+        if (W.dist(v) != Workspace::infinity) {
+            T.dist[v] = W.dist(v);
+            T.path[v] = W.path(v);
+        }
+    }
+    return T;
+}
+
+namespace {
+
+// Path s, ..., meet, ..., t from the parents of the forward search (towards s) and of the backward search (towards t)
+std::vector<int> joinPaths(const Workspace& forward, const Workspace& backward, int meet) {
+    std::vector<int> result;
+    for (int v = meet; v != 0; v = forward.path(v)) {
+        result.push_back(v);
+    }
+    std::reverse(result.begin(), result.end());
+    for (int v = backward.path(meet); v != 0; v = backward.path(v)) {
+        result.push_back(v);
+    }
+    return result;
+}
+
+}  // namespace
+
+// shortest unweighted path from s to t
+// bidirectional BFS, stops as soon as the two searches meet
+PathResult Digraph::uwpath(int s, int t) const {
     assert(s >= 1 && s <= size);
+    assert(t >= 1 && t <= size);
 
-    // *** TODO ***
-    // dist vector should be initialized with std::numeric_limits<int>::max()
-    for (int i = 0; i <= size; i++) {
-        dist[i] = std::numeric_limits<int>::max();
-        path[i] = 0;
-        done[i] = false;
+    PathResult result;
+    if (s == t) {
+        return {0, {s}, 1};
+    }
+
+    // Index 0 is the search from s along the edges, index 1 the search from t against the edges
+    const CSR* G[2] = {&adjacency(), &reverseAdjacency()};
+    Workspace* W[2] = {&workspace(Search::Forward), &workspace(Search::Backward)};
+    std::vector<int> frontier[2] = {{s}, {t}};
+    W[0]->set(s, 0, 0);
+    W[1]->set(t, 0, 0);
+
+    int best = Workspace::infinity;
+    int meet = 0;
+
+    while (!frontier[0].empty() && !frontier[1].empty()) {
+        // Expand a whole level of the smaller frontier
+        const int side = (frontier[0].size() <= frontier[1].size()) ? 0 : 1;
+        const CSR& A = *G[side];
+        Workspace& D = *W[side];
+        const Workspace& other = *W[1 - side];
+
+        std::vector<int> next;
+        for (int v : frontier[side]) {
+            ++result.settled;
+            for (int i = A.first(v); i < A.last(v); ++i) {
+                int u = A.targets[i];
+
+                if (other.dist(u) != Workspace::infinity && D.dist(v) + 1 + other.dist(u) < best) {
+                    // The searches meet: a path through edge (v, u)
+                    best = D.dist(v) + 1 + other.dist(u);
+                    meet = u;
+                }
+                if (D.dist(u) == Workspace::infinity) {
+                    D.set(u, D.dist(v) + 1, v);
+                    next.push_back(u);
+                }
+            }
+        }
+        frontier[side] = std::move(next);
+
+        // All paths found later are longer than the ones through this level
+        if (meet != 0) break;
+    }
+
+    if (meet != 0) {
+        result.distance = best;
+        result.path = joinPaths(*W[0], *W[1], meet);
     }
-    dist[s] = 0;
-    done[s] = true;
+    return result;
+}
+
+// shortest positive weighted path from s to t
+// bidirectional Dijkstra, stops as soon as no shorter path through the two searches is possible
+PathResult Digraph::pwpath(int s, int t) const {
+    assert(s >= 1 && s <= size);
+    assert(t >= 1 && t <= size);
+
+    // Index 0 is the search from s along the edges, index 1 the search from t against the edges
+    const CSR* G[2] = {&adjacency(), &reverseAdjacency()};
+    Workspace* W[2] = {&workspace(Search::Forward), &workspace(Search::Backward)};
+
+    using Entry = std::pair<int, int>;  // (dist, vertex)
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> Q[2];
+    W[0]->set(s, 0, 0);
+    W[1]->set(t, 0, 0);
+    Q[0].push({0, s});
+    Q[1].push({0, t});
+
+    PathResult result;
+    int best = (s == t) ? 0 : Workspace::infinity;
+    int meet = (s == t) ? s : 0;
+
+    while (!Q[0].empty() && !Q[1].empty()) {
+        // No path through unsettled vertices can be shorter than best
+        if (Q[0].top().first + Q[1].top().first >= best) break;
+
+        // Advance the search with the closer vertex
+        const int side = (Q[0].top().first <= Q[1].top().first) ? 0 : 1;
+        const CSR& A = *G[side];
+        Workspace& D = *W[side];
+        const Workspace& other = *W[1 - side];
+
+        auto [dv, v] = Q[side].top();
+        Q[side].pop();
 
-    int v = s;
+        if (D.done(v)) continue;
+        D.setDone(v);
+        ++result.settled;
 
-    while (true) {
-        for (auto& e : table[v]) {
-            int u = e.to;
+        for (int i = A.first(v); i < A.last(v); ++i) {
+            int u = A.targets[i];
 
-            if (done[u] == false && dist[u] > dist[v] + e.weight) {
-                dist[u] = dist[v] + e.weight;
-                path[u] = v;
+            if (dv + A.weights[i] < D.dist(u)) {
+                D.set(u, dv + A.weights[i], v);
+                Q[side].push({D.dist(u), u});
+            }
+            if (other.dist(u) != Workspace::infinity && D.dist(u) + other.dist(u) < best) {
+                best = D.dist(u) + other.dist(u);
+                meet = u;
             }
         }
+    }
+
+    if (meet != 0) {
+        result.distance = best;
+        result.path = joinPaths(*W[0], *W[1], meet);
+    }
+    return result;
+}
 
-        // find smallest undone distance vertex
+// shortest positive weighted path from s to t, A* search
+// heuristic(v) must never exceed the distance from v to t, e.g. the straight line distance
+PathResult Digraph::pwpath(int s, int t, const std::function<int(int)>& heuristic) const {
+    assert(s >= 1 && s <= size);
+    assert(t >= 1 && t <= size);
+
+    const CSR& G = adjacency();
+    Workspace& W = workspace(Search::Forward);
+
+    // Vertices ordered by their distance from s plus the estimated distance to t
+    // A heuristic that is admissible but not consistent may lower the distance of a vertex after it was
+    // popped, it is then pushed again
+    using Entry = std::pair<int, int>;  // (dist + heuristic, vertex)
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> Q;
+    W.set(s, 0, 0);
+    Q.push({heuristic(s), s});
+
+    PathResult result;
+    while (!Q.empty()) {
+        auto [f, v] = Q.top();
+        Q.pop();
 
-        int min = std::numeric_limits<int>::max();
-        for (auto& e : table[v]) {
-            int u = e.to;
-            if (done[u] == false && dist[u] < min) {
-                min = dist[u];
-                v = u;
+        if (f - heuristic(v) > W.dist(v)) continue;  // outdated entry
+        ++result.settled;
+
+        // The first time t is popped its distance is final
+        if (v == t) {
+            result.distance = W.dist(t);
+            for (int u = t; u != 0; u = W.path(u)) {
+                result.path.push_back(u);
             }
+            std::reverse(result.path.begin(), result.path.end());
+            break;
         }
 
-        if (min == std::numeric_limits<int>::max()) break;
-        done[v] = true;
+        for (int i = G.first(v); i < G.last(v); ++i) {
+            int u = G.targets[i];
+
+            if (W.dist(v) + G.weights[i] < W.dist(u)) {
+                W.set(u, W.dist(v) + G.weights[i], v);
+                Q.push({W.dist(u) + heuristic(u), u});
+            }
+        }
     }
-    std::cout << "\n";
-    printTree();
+    return result;
+}
+
+// answer all queries (s, t) with uwpath, on the given number of threads (0: all hardware threads)
+std::vector<PathResult> Digraph::uwpaths(const std::vector<std::pair<int, int>>& queries, unsigned threads) const {
+    reverseAdjacency();  // build both adjacencies before the threads start
+    return runBatch(queries.size(), threads,
+                    [this, &queries](std::size_t i) { return uwpath(queries[i].first, queries[i].second); });
+}
+
+// answer all queries (s, t) with pwpath, on the given number of threads (0: all hardware threads)
+std::vector<PathResult> Digraph::pwpaths(const std::vector<std::pair<int, int>>& queries, unsigned threads) const {
+    reverseAdjacency();  // build both adjacencies before the threads start
+    return runBatch(queries.size(), threads,
+                    [this, &queries](std::size_t i) { return pwpath(queries[i].first, queries[i].second); });
 }
 
 // print graph
@@ -151,10 +870,12 @@ void Digraph::printGraph() const {
     std::cout << "Vertex  adjacency lists\n";
     std::cout << std::format("{:-<66}\n", '-');
 
+    // The adjacency holds the edges of every vertex in the order of its list
+    const CSR& G = adjacency();
     for (int v = 1; v <= size; ++v) {
         std::cout << std::format("{:4} : ", v);
-        for (auto const& e : table[v]) {
-            std::cout << std::format("({:2}, {:2}) ", e.to, e.weight);
+        for (int i = G.first(v); i < G.last(v); ++i) {
+            std::cout << std::format("({:2}, {:2}) ", G.targets[i], G.weights[i]);
         }
         std::cout << "\n";
     }
@@ -169,10 +890,13 @@ void Digraph::printTree() const {
     std::cout << std::format("{:-<22}\n", '-');
     // std::cout << "----------------------\n";
 
+    // Without a tree all vertices are unreached
+    const Workspace* W = tree();
     for (int v = 1; v <= size; ++v) {
+        const int dist = W ? W->dist(v) : Workspace::infinity;
         std::cout << std::format("{:4} : {:6} {:6}\n", v,
-                                 ((dist[v] == std::numeric_limits<int>::max()) ? -1 : dist[v]),
-                                 path[v]);
+                                 ((dist == Workspace::infinity) ? -1 : dist),
+                                 W ? W->path(v) : 0);
     }
     std::cout << std::format("{:-<22}\n", '-');
     // std::cout << "----------------------\n";
@@ -182,22 +906,26 @@ void Digraph::printTree() const {
 // Hint: consider using recursion
 void Digraph::printPath(int t) const {
     assert(t >= 1 && t <= size);
-    
-    auto sit = std::min_element(dist.begin(), dist.end());
-    int s = *sit;
+
+    const Workspace* W = tree();
+    if (!W) {
+        std::cout << " no shortest path tree\n";
+        return;
+    }
 
     // *** TODO ***
 
     std::vector<int> shortpath;
 
+    // path is 0 for the start vertex s
     int v = t;
-    while (v != s) {
+    while (v != 0) {
         shortpath.push_back(v);
-        v = path[v];
+        v = W->path(v);
     }
 
     for (int i = shortpath.size() - 1; i >= 0; i--) {
         std::cout<< " " << shortpath[i] << "  ";
     }
-    std::cout << "(" << dist[t] << ")\n";
+    std::cout << "(" << W->dist(t) << ")\n";
 }
\ No newline at end of file
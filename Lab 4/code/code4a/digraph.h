@@ -7,14 +7,40 @@
 
 #include <list>
 #include <vector>
+#include <unordered_map>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <utility>
 
 #include "edge.h"
+#include "csr.h"
+#include "workspace.h"
+
+// Result of a shortest path query from s to t
+struct PathResult {
+    int distance{-1};       // length of the path, -1 if t cannot be reached from s
+    std::vector<int> path;  // the vertices s, ..., t on the path, empty if t cannot be reached
+    int settled{0};         // number of vertices whose distance was fixed by the search
+};
+
+// Shortest path tree from a start vertex
+struct PathTree {
+    int source{0};          // start vertex
+    std::vector<int> dist;  // dist[v] is the length of the shortest path to v, -1 if v cannot be reached
+    std::vector<int> path;  // path[v] is the previous vertex on that path, 0 for source and unreachable vertices
+};
 
 class Digraph {
 public:
     // -- CONSTRUCTOR
     // Create a digraph with n vertices and the edges in V
-    Digraph(const std::vector<Edge>& V, int n);
+    // With useEdgeIndex, insertEdge and removeEdge find an edge in O(1) instead of O(out-degree)
+    Digraph(const std::vector<Edge>& V, int n, bool useEdgeIndex = false);
+
+    // Create a digraph with the given adjacency, e.g. a mapped binary graph file (see graphfile.h)
+    // The queries use G as it is, the adjacency lists are only built when the digraph is modified
+    explicit Digraph(CSR G, bool useEdgeIndex = false);
 
     // Disallow copying
     Digraph(const Digraph&) = delete;
@@ -22,6 +48,16 @@ public:
 
     // -- MEMBER FUNCTIONS
 
+    // number of vertices
+    int vertices() const {
+        return size;
+    }
+
+    // number of edges
+    int edges() const {
+        return n_edges;
+    }
+
     // insert directed edge e = (u, v, w)
     // update weight w if edge (u, v) is present
     void insertEdge(const Edge& e);
@@ -29,37 +65,127 @@ public:
     // remove directed edge e
     void removeEdge(const Edge& e);
 
+    // Queries only read the graph, any number of threads can run them at the same time
+    // Modifying the graph while queries are running is not allowed
+
+    // The sssp functions keep the tree for printTree and printPath, the tree functions return it
+
     // construct unweighted single source shortest path-tree for start vertex s
-    void uwsssp(int s) const;
+    // large graphs are searched in parallel on the given number of threads, 0 uses all hardware threads
+    void uwsssp(int s, unsigned threads = 0) const;
 
     // construct positive weighted single source shortest path-tree for start vertex s
-    // Dijktra's algorithm
-    void pwsssp(int s) const;
+    // Dijkstra's algorithm, large graphs are searched in parallel by delta-stepping (see pwtree)
+    void pwsssp(int s, unsigned threads = 0, int delta = 0) const;
+
+    // unweighted single source shortest path-tree for start vertex s, threads as for uwsssp
+    PathTree uwtree(int s, unsigned threads = 0) const;
+
+    // positive weighted single source shortest path-tree for start vertex s
+    // large graphs are searched by delta-stepping on the given number of threads, 0 uses all hardware threads
+    // delta is the width of the distance buckets, 0 picks one from the weights and the average degree, it is
+    // raised to the heaviest edge / 65536 so that the number of buckets stays bounded
+    // of several shortest paths to a vertex the one through the smallest previous vertex is chosen, also when
+    // the graph is searched by one thread
+    PathTree pwtree(int s, unsigned threads = 0, int delta = 0) const;
+
+    // shortest unweighted path from s to t
+    // bidirectional BFS, stops as soon as the two searches meet
+    PathResult uwpath(int s, int t) const;
+
+    // shortest positive weighted path from s to t
+    // bidirectional Dijkstra, stops as soon as no shorter path through the two searches is possible
+    PathResult pwpath(int s, int t) const;
+
+    // shortest positive weighted path from s to t, A* search
+    // heuristic(v) must never exceed the distance from v to t, e.g. the straight line distance
+    PathResult pwpath(int s, int t, const std::function<int(int)>& heuristic) const;
+
+    // answer all queries (s, t) with uwpath or pwpath, in parallel on the given number of threads
+    // 0 threads uses all hardware threads, the results are in the order of the queries
+    std::vector<PathResult> uwpaths(const std::vector<std::pair<int, int>>& queries, unsigned threads = 0) const;
+    std::vector<PathResult> pwpaths(const std::vector<std::pair<int, int>>& queries, unsigned threads = 0) const;
 
     // print graph
     void printGraph() const;
 
     // print shortest path tree for s
+    // the tree of the last call to uwsssp or pwsssp by the calling thread
     void printTree() const;
 
     // print shortest path from s to t and the corresponding path length
+    // s is the start vertex of the last call to uwsssp or pwsssp by the calling thread
     void printPath(int t) const;
 
+    // builds its hierarchy from adjacency()
+    friend class ContractionHierarchy;
+
 private:
+    // flat copy of table used by the queries, rebuilt after the graph was modified
+    const CSR& adjacency() const;
+
+    // the same with all edges reversed, used by the backward search of uwpath and pwpath
+    const CSR& reverseAdjacency() const;
+
+    // searches that need their own workspace
+    enum class Search { Tree, Forward, Backward };
+
+    // workspace of the calling thread for the given search, reset for a search on this graph
+    Workspace& workspace(Search search) const;
+
+    // workspace holding the tree of the last uwsssp or pwsssp call on this graph by the calling thread,
+    // nullptr if there is none
+    const Workspace* tree() const;
+
+    // BFS and Dijkstra from s into the given workspace of the calling thread
+    const Workspace& uwsearch(int s, Search search) const;
+    const Workspace& pwsearch(int s, Search search) const;
+
+    // the same BFS on the given number of threads, the tree is the one of uwsearch(s, search)
+    const Workspace& uwsearch(int s, Search search, unsigned threads) const;
+
+    // delta-stepping on the given number of threads, the distances are the ones of pwsearch(s, search)
+    const Workspace& pwsearch(int s, Search search, unsigned threads, int delta) const;
+
+    // copy of the tree in W
+    PathTree toTree(const Workspace& W) const;
+
+    // fill table from csr, if the digraph was created from an adjacency
+    void buildTable();
+
+    // edge (u, v) in table[u], or end(table[u]) if there is no such edge
+    std::list<Edge>::iterator findEdge(int u, int v);
+
+    // key of edge (u, v) in edge_index
+    long long edgeKey(int u, int v) const {
+        return static_cast<long long>(u) * (size + 1) + v;
+    }
+
     // -- DATA MEMBERS
     std::vector<std::list<Edge>> table;  // table of adjacency lists
+    bool has_table{true};                // false until buildTable() is called for a digraph made from a CSR
     int size;                            // number of vertices
     int n_edges;                         // number of edges
 
+    // insertEdge and removeEdge only modify table and mark csr as outdated
+    // queries only lock the mutex if csr is outdated, so that concurrent queries rebuild it only once
+    mutable std::mutex csr_mutex;
+    mutable CSR csr;
+    mutable std::atomic<bool> csr_dirty{true};
+    mutable CSR reverse_csr;
+    mutable std::vector<int> reverse_edge;  // reverse_edge[j] is the index in csr of edge j of reverse_csr
+    mutable std::atomic<bool> reverse_csr_dirty{true};
+
+    // optional index of all edges: (u, v) -> position in table[u]
+    bool use_edge_index{false};
+    std::unordered_map<long long, std::list<Edge>::iterator> edge_index;
+
     /*
-     * vectors below can be modified by const - member functions
-     * these vectors are used by member functions uwsssp and pwsssp to store info related to
-     * shortest paths
-     * member functions printTree and printPath need also access to these vectors
+     * The distances, paths and done flags of the queries are stored in per-thread workspaces, see
+     * workspace(), instead of in the graph. They are reset lazily, so a query only pays for the
+     * vertices it reaches. id tells the workspaces of different graphs apart
      */
-    mutable std::vector<int> dist;
-    mutable std::vector<int> path;
-    mutable std::vector<bool> done;  // just used in Dijktras algorithm
+    unsigned long long id;
 
     // -- Private CONSTRUCTOR
     explicit Digraph(int n);
@@ -0,0 +1,159 @@
+/*********************************************
+ * file:	~\code4a\graphfile.cpp            *
+ * remark: binary graph files                 *
+ **********************************************/
+
+#include <fstream>
+#include <stdexcept>
+#include <cstring>  //std::memcmp
+#include <cstdint>  //std::int64_t
+#include <limits>   //std::numeric_limits
+#include <memory>
+#include <span>
+#include <algorithm>  //std::any_of
+#include <format>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "graphfile.h"
+
+namespace {
+
+constexpr char magic[8] = {'T', 'N', 'D', '4', 'C', 'S', 'R', '1'};
+
+struct Header {
+    char magic[8];
+    std::int64_t vertices;
+    std::int64_t edges;
+};
+
+// A whole file mapped read-only into memory, unmapped when destroyed
+class Mapping {
+public:
+    explicit Mapping(const std::filesystem::path& file) {
+#if defined(_WIN32)
+        HANDLE handle = CreateFileW(file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                    FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle == INVALID_HANDLE_VALUE) fail(file);
+
+        LARGE_INTEGER length{};
+        HANDLE mapping = nullptr;
+        if (GetFileSizeEx(handle, &length) && length.QuadPart > 0) {
+            size = static_cast<std::size_t>(length.QuadPart);
+            mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        }
+        if (mapping) {
+            data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);  // the view keeps the mapping alive
+        }
+        CloseHandle(handle);
+#else
+        const int fd = open(file.c_str(), O_RDONLY);
+        if (fd == -1) fail(file);
+
+        struct stat info{};
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            size = static_cast<std::size_t>(info.st_size);
+            void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) data = p;
+        }
+        close(fd);  // the mapping stays valid
+#endif
+        if (!data) fail(file);
+    }
+
+    ~Mapping() {
+#if defined(_WIN32)
+        UnmapViewOfFile(data);
+#else
+        munmap(const_cast<void*>(data), size);
+#endif
+    }
+
+    Mapping(const Mapping&) = delete;
+    Mapping& operator=(const Mapping&) = delete;
+
+    // -- DATA MEMBERS
+    const void* data{nullptr};
+    std::size_t size{0};
+
+private:
+    [[noreturn]] static void fail(const std::filesystem::path& file) {
+        throw std::runtime_error(std::format("can not map {}", file.string()));
+    }
+};
+
+}  // namespace
+
+// The adjacency of a digraph with n vertices and the edges in V, as Digraph{V, n} stores it
+CSR fileAdjacency(const std::vector<Edge>& V, int n) {
+    return CSR{V, n};
+}
+
+// Write G as a binary graph file
+void writeGraphFile(const std::filesystem::path& file, const CSR& G) {
+    Header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.vertices = std::ssize(G.offsets) - 2;
+    header.edges = std::ssize(G.targets);
+
+    std::ofstream out{file, std::ios::binary};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (std::span<const int> V : {G.offsets, G.targets, G.weights}) {
+        out.write(reinterpret_cast<const char*>(V.data()), static_cast<std::streamsize>(V.size_bytes()));
+    }
+    if (!out) throw std::runtime_error(std::format("can not write {}", file.string()));
+}
+
+// Map a binary graph file into memory
+CSR mapGraphFile(const std::filesystem::path& file) {
+    auto mapping = std::make_shared<const Mapping>(file);
+    const auto* bytes = static_cast<const char*>(mapping->data);
+
+    Header header{};
+    if (mapping->size >= sizeof(header)) std::memcpy(&header, bytes, sizeof(header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0) {
+        throw std::runtime_error(std::format("{} is not a binary graph file", file.string()));
+    }
+
+    const std::int64_t n = header.vertices;
+    const std::int64_t m = header.edges;
+    const bool sizes = n >= 1 && m >= 0 && n < std::numeric_limits<int>::max() && m <= std::numeric_limits<int>::max() &&
+                       mapping->size == sizeof(header) + sizeof(int) * static_cast<std::size_t>(n + 2 + 2 * m);
+    if (!sizes) throw std::runtime_error(std::format("binary graph file {} is damaged", file.string()));
+
+    // The arrays follow the header, which keeps them aligned
+    const int* offsets = reinterpret_cast<const int*>(bytes + sizeof(header));
+    const int* targets = offsets + (n + 2);
+    const int* weights = targets + m;
+
+    // Every edge has to be in the targets array, O(V)
+    bool ordered = offsets[0] == 0 && offsets[n + 1] == m;
+    for (std::int64_t v = 0; ordered && v <= n; ++v) {
+        ordered = offsets[v] <= offsets[v + 1];
+    }
+    if (!ordered) throw std::runtime_error(std::format("binary graph file {} is damaged", file.string()));
+
+    return {mapping, {offsets, static_cast<std::size_t>(n + 2)}, {targets, static_cast<std::size_t>(m)},
+            {weights, static_cast<std::size_t>(m)}};
+}
+
+// Map a binary graph file and check that every edge ends in a vertex of the graph
+CSR verifyGraphFile(const std::filesystem::path& file) {
+    CSR G = mapGraphFile(file);
+
+    const int n = static_cast<int>(G.offsets.size()) - 2;
+    if (std::any_of(G.targets.begin(), G.targets.end(), [n](int v) { return v < 1 || v > n; })) {
+        throw std::runtime_error(
+            std::format("binary graph file {} has an edge to a vertex not in 1..{}", file.string(), n));
+    }
+    return G;
+}
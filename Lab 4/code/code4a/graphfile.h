@@ -0,0 +1,35 @@
+/*********************************************
+ * file:	~\code4a\graphfile.h              *
+ * remark: binary graph files                 *
+ **********************************************/
+
+#pragma once
+
+#include <vector>
+#include <filesystem>
+
+#include "edge.h"
+#include "csr.h"
+
+/*
+ * A binary graph file holds the CSR arrays of a graph just as they are in memory, so that opening it
+ * only maps the file and does no work per edge.
+ * Layout: the 8 bytes "TND4CSR1", the number of vertices n and of edges m as 64-bit integers, then
+ * offsets (n + 2 entries), targets (m entries) and weights (m entries) as 32-bit integers.
+ * All numbers are in the byte order of the machine that wrote the file.
+ */
+
+// The adjacency of a digraph with n vertices and the edges in V, as Digraph{V, n} stores it
+CSR fileAdjacency(const std::vector<Edge>& V, int n);
+
+// Write G as a binary graph file, throws std::runtime_error if the file can not be written
+void writeGraphFile(const std::filesystem::path& file, const CSR& G);
+
+// Map a binary graph file into memory, the arrays of the returned CSR are the mapped file
+// The sizes and the offsets are checked in O(V), the targets are not, see verifyGraphFile
+// throws std::runtime_error if the file can not be mapped or is damaged
+CSR mapGraphFile(const std::filesystem::path& file);
+
+// Map a binary graph file and also check that every edge ends in a vertex 1..n, which reads all edges
+// throws std::runtime_error if the file can not be mapped or is damaged
+CSR verifyGraphFile(const std::filesystem::path& file);
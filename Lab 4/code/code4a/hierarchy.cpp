@@ -0,0 +1,421 @@
+/*********************************************
+ * file:	~\code4a\hierarchy.cpp            *
+ * remark: contraction hierarchy of a digraph *
+ **********************************************/
+
+#include <algorithm>
+#include <cassert>
+#include <queue>
+#include <utility>     //std::pair
+#include <tuple>       //std::tie
+#include <functional>  //std::greater
+#include <fstream>
+#include <stdexcept>
+#include <span>
+#include <cstring>  //std::memcmp
+#include <limits>   //std::numeric_limits
+#include <format>
+
+#include "hierarchy.h"
+#include "workspace.h"
+
+namespace {
+
+// A witness search gives up after settling this many vertices and a shortcut is added instead
+// Extra shortcuts only cost query time, they never make a distance wrong
+constexpr int witness_limit = 500;
+
+// Edge of the graph while it is contracted, stored at both ends
+// In out[v] to is the end vertex, in in[v] the start vertex
+struct Arc {
+    int to;
+    int weight;
+    int via;  // vertex skipped by a shortcut, 0 for an edge of the digraph
+};
+
+// The remaining graph during preprocessing, the removed vertices have no arcs
+class Contraction {
+public:
+    explicit Contraction(const CSR& G, int n) : out(n + 1), in(n + 1), removed_neighbours(n + 1, 0) {
+        for (int v = 1; v <= n; ++v) {
+            for (int i = G.first(v); i < G.last(v); ++i) {
+                if (G.targets[i] == v) continue;  // never on a shortest path
+                out[v].push_back({G.targets[i], G.weights[i], 0});
+                in[G.targets[i]].push_back({v, G.weights[i], 0});
+            }
+        }
+    }
+
+    // Remove v, adding the shortcuts needed to keep all distances between the remaining vertices
+    // With simulate nothing changes, the return value is the number of shortcuts that would be added
+    int contract(int v, bool simulate) {
+        int max_out = 0;
+        for (auto const& a : out[v]) max_out = std::max(max_out, a.weight);
+
+        int shortcuts = 0;
+        for (auto const& from : in[v]) {
+            const int u = from.to;
+            witnessSearch(u, v, from.weight + max_out);
+
+            for (auto const& to : out[v]) {
+                const int w = to.to;
+                const int length = from.weight + to.weight;
+                if (w == u || witness.dist(w) <= length) continue;
+
+                ++shortcuts;
+                if (!simulate) addArc(u, w, length, v);
+            }
+        }
+
+        if (!simulate) {
+            for (auto const& a : in[v]) {
+                eraseArc(out[a.to], v);
+                ++removed_neighbours[a.to];
+            }
+            for (auto const& a : out[v]) {
+                eraseArc(in[a.to], v);
+                ++removed_neighbours[a.to];
+            }
+        }
+        return shortcuts;
+    }
+
+    // Vertices that add few shortcuts compared to the arcs they remove go first
+    // Counting the removed neighbours spreads the removed vertices evenly over the graph
+    int priority(int v) {
+        const int shortcuts = contract(v, true);
+        return shortcuts - static_cast<int>(in[v].size() + out[v].size()) + removed_neighbours[v];
+    }
+
+    // -- DATA MEMBERS
+    std::vector<std::vector<Arc>> out;
+    std::vector<std::vector<Arc>> in;
+
+private:
+    // Dijkstra from u that avoids v, up to distance limit or witness_limit settled vertices
+    void witnessSearch(int u, int v, int limit) {
+        witness.reset(static_cast<int>(out.size()) - 1);
+        witness.set(u, 0, 0);
+
+        using Entry = std::pair<int, int>;  // (dist, vertex)
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> Q;
+        Q.push({0, u});
+
+        int settled = 0;
+        while (!Q.empty() && settled < witness_limit) {
+            auto [d, x] = Q.top();
+            Q.pop();
+
+            if (witness.done(x)) continue;
+            if (d > limit) break;
+            witness.setDone(x);
+            ++settled;
+
+            for (auto const& a : out[x]) {
+                if (a.to != v && d + a.weight < witness.dist(a.to)) {
+                    witness.set(a.to, d + a.weight, x);
+                    Q.push({d + a.weight, a.to});
+                }
+            }
+        }
+    }
+
+    // add the shortcut (u, w) or make the present arc shorter
+    void addArc(int u, int w, int length, int via) {
+        auto it = std::find_if(out[u].begin(), out[u].end(), [w](const Arc& a) { return a.to == w; });
+        if (it == out[u].end()) {
+            out[u].push_back({w, length, via});
+            in[w].push_back({u, length, via});
+        } else if (length < it->weight) {
+            *it = {w, length, via};
+            *std::find_if(in[w].begin(), in[w].end(), [u](const Arc& a) { return a.to == u; }) = {u, length, via};
+        }
+    }
+
+    static void eraseArc(std::vector<Arc>& arcs, int v) {
+        std::erase_if(arcs, [v](const Arc& a) { return a.to == v; });
+    }
+
+    Workspace witness;
+    std::vector<int> removed_neighbours;
+};
+
+// Flat copy of the arcs stored at every vertex, sorted by target
+void flatten(const std::vector<std::vector<Arc>>& arcs, CSR& G, std::vector<int>& via) {
+    std::vector<int> offsets(arcs.size() + 1, 0);
+    for (std::size_t v = 0; v < arcs.size(); ++v) {
+        offsets[v + 1] = offsets[v] + static_cast<int>(arcs[v].size());
+    }
+
+    std::vector<int> targets;
+    std::vector<int> weights;
+    for (auto list : arcs) {
+        std::sort(list.begin(), list.end(), [](const Arc& a, const Arc& b) { return a.to < b.to; });
+        for (auto const& a : list) {
+            targets.push_back(a.to);
+            weights.push_back(a.weight);
+            via.push_back(a.via);
+        }
+    }
+    G = CSR{std::move(offsets), std::move(targets), std::move(weights)};
+}
+
+// workspaces of the calling thread for the search from s and the distances found by sweep
+Workspace& queryWorkspace(int side) {
+    thread_local Workspace workspaces[2];
+    return workspaces[side];
+}
+
+// -- FILE FORMAT: magic, then the contraction order and the arrays of up and down, each preceded by its length
+constexpr char magic[8] = {'T', 'N', 'D', '4', 'C', 'H', '0', '1'};
+
+void write(std::ofstream& file, std::span<const int> V) {
+    const long long count = std::ssize(V);
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    file.write(reinterpret_cast<const char*>(V.data()), static_cast<std::streamsize>(V.size() * sizeof(int)));
+}
+
+std::vector<int> read(std::ifstream& file) {
+    long long count = -1;
+    file.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!file || count < 0 || count > std::numeric_limits<int>::max()) {
+        throw std::runtime_error("contraction hierarchy file is damaged");
+    }
+
+    std::vector<int> V(static_cast<std::size_t>(count));
+    file.read(reinterpret_cast<char*>(V.data()), static_cast<std::streamsize>(V.size() * sizeof(int)));
+    if (!file) throw std::runtime_error("contraction hierarchy file is damaged");
+    return V;
+}
+
+}  // namespace
+
+// -- CONSTRUCTORS
+
+// Build the hierarchy of G
+ContractionHierarchy::ContractionHierarchy(const Digraph& G) : size{G.size} {
+    Contraction C{G.adjacency(), size};
+
+    // Vertices by priority, a priority is recomputed when its vertex comes up and pushed again if it grew
+    using Entry = std::pair<int, int>;  // (priority, vertex)
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> Q;
+    for (int v = 1; v <= size; ++v) {
+        Q.push({C.priority(v), v});
+    }
+
+    std::vector<std::vector<Arc>> up_arcs(size + 1);
+    std::vector<std::vector<Arc>> down_arcs(size + 1);
+    std::vector<bool> removed(size + 1, false);
+
+    while (!Q.empty()) {
+        auto [p, v] = Q.top();
+        Q.pop();
+        if (removed[v]) continue;
+
+        if (const int now = C.priority(v); !Q.empty() && now > Q.top().first) {
+            Q.push({now, v});
+            continue;
+        }
+
+        // The arcs left at v all lead to vertices removed later
+        up_arcs[v] = C.out[v];
+        down_arcs[v] = C.in[v];
+        C.contract(v, false);
+        C.out[v].clear();
+        C.in[v].clear();
+
+        removed[v] = true;
+        contraction_order.push_back(v);
+    }
+
+    flatten(up_arcs, up, up_via);
+    flatten(down_arcs, down, down_via);
+    setRanks();
+    setInEdges();
+}
+
+// -- MEMBER FUNCTIONS
+
+// shortest positive weighted path from s to t
+// Every shortest path goes up the hierarchy and then down. Dijkstra from s along up finds the distances of the
+// first part, sweep adds the second part for the vertices the path needs. The path is then walked back from t
+// through the smallest previous vertex whose distance plus the edge is the distance of the vertex.
+PathResult ContractionHierarchy::path(int s, int t) const {
+    assert(s >= 1 && s <= size);
+    assert(t >= 1 && t <= size);
+
+    Workspace& upward = queryWorkspace(0);
+    Workspace& known = queryWorkspace(1);
+    upward.reset(size);
+    known.reset(size);
+
+    PathResult result;
+    using Entry = std::pair<int, int>;  // (dist, vertex)
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> Q;
+    upward.set(s, 0, 0);
+    Q.push({0, s});
+
+    while (!Q.empty()) {
+        auto [dv, v] = Q.top();
+        Q.pop();
+
+        if (upward.done(v)) continue;
+        upward.setDone(v);
+        ++result.settled;
+
+        for (int i = up.first(v); i < up.last(v); ++i) {
+            int u = up.targets[i];
+
+            if (dv + up.weights[i] < upward.dist(u)) {
+                upward.set(u, dv + up.weights[i], v);
+                Q.push({upward.dist(u), u});
+            }
+        }
+    }
+
+    result.settled += sweep(t, upward, known);
+    if (known.dist(t) == Workspace::infinity) return result;
+    result.distance = known.dist(t);
+
+    std::vector<int> reversed{t};
+    for (int v = t; v != s; reversed.push_back(v)) {
+        int previous = 0;
+        for (int i = in_edges.first(v); i < in_edges.last(v) && previous == 0; ++i) {
+            const int u = in_edges.targets[i];
+            const int w = in_edges.weights[i];
+            if (w > known.dist(v)) continue;
+
+            result.settled += sweep(u, upward, known);
+            if (known.dist(u) == known.dist(v) - w) previous = u;
+        }
+        assert(previous != 0);
+        v = previous;
+    }
+
+    result.path.assign(reversed.rbegin(), reversed.rend());
+    return result;
+}
+
+// distance from s to v, given the search from s towards vertices removed later in upward
+// The shortest path to v either only goes up, or ends with an edge (u, v) of down from a vertex u removed after
+// v, so the vertices above v are done first. Every vertex is done once per query, its distance is kept in known
+int ContractionHierarchy::sweep(int v, const Workspace& upward, Workspace& known) const {
+    int added = 0;
+    std::vector<int> stack{v};
+    while (!stack.empty()) {
+        const int x = stack.back();
+        if (known.done(x)) {
+            stack.pop_back();
+            continue;
+        }
+
+        bool ready = true;
+        for (int i = down.first(x); i < down.last(x); ++i) {
+            if (!known.done(down.targets[i])) {
+                stack.push_back(down.targets[i]);
+                ready = false;
+            }
+        }
+        if (!ready) continue;
+
+        stack.pop_back();
+        int d = upward.dist(x);
+        for (int i = down.first(x); i < down.last(x); ++i) {
+            const int du = known.dist(down.targets[i]);
+            if (du != Workspace::infinity) d = std::min(d, du + down.weights[i]);
+        }
+        known.set(x, d, 0);
+        known.setDone(x);
+        ++added;
+    }
+    return added;
+}
+
+// Store the hierarchy in a binary file
+void ContractionHierarchy::save(const std::filesystem::path& file) const {
+    std::ofstream out{file, std::ios::binary};
+    out.write(magic, sizeof(magic));
+    write(out, contraction_order);
+    for (auto const* G : {&up, &down}) {
+        write(out, G->offsets);
+        write(out, G->targets);
+        write(out, G->weights);
+        write(out, (G == &up) ? up_via : down_via);
+    }
+    if (!out) throw std::runtime_error(std::format("can not write {}", file.string()));
+}
+
+// Read a hierarchy written by save()
+ContractionHierarchy ContractionHierarchy::load(const std::filesystem::path& file) {
+    std::ifstream in{file, std::ios::binary};
+    if (!in) throw std::runtime_error(std::format("can not read {}", file.string()));
+
+    char header[sizeof(magic)] = {};
+    in.read(header, sizeof(header));
+    if (!in || std::memcmp(header, magic, sizeof(magic)) != 0) {
+        throw std::runtime_error(std::format("{} is not a contraction hierarchy file", file.string()));
+    }
+
+    ContractionHierarchy H;
+    H.contraction_order = read(in);
+    H.size = static_cast<int>(H.contraction_order.size());
+    H.setRanks();
+
+    // The parts must fit together, the queries do not check them
+    const auto damaged = std::format("contraction hierarchy file {} is damaged", file.string());
+    if (H.rank.empty()) throw std::runtime_error(damaged);
+
+    for (auto [G, via] : {std::pair{&H.up, &H.up_via}, std::pair{&H.down, &H.down_via}}) {
+        auto offsets = read(in);
+        auto targets = read(in);
+        auto weights = read(in);
+        *via = read(in);
+
+        const int n = H.size;
+        const bool fits = std::ssize(offsets) == n + 2 && offsets.front() == 0 &&
+                          std::is_sorted(offsets.begin(), offsets.end()) && offsets.back() == std::ssize(targets) &&
+                          targets.size() == weights.size() && targets.size() == via->size() &&
+                          std::all_of(targets.begin(), targets.end(), [n](int v) { return v >= 1 && v <= n; }) &&
+                          std::all_of(via->begin(), via->end(), [n](int v) { return v >= 0 && v <= n; });
+        if (!fits) throw std::runtime_error(damaged);
+
+        *G = CSR{std::move(offsets), std::move(targets), std::move(weights)};
+    }
+    H.setInEdges();
+    return H;
+}
+
+// rank[v] is the position of v in contraction_order, empty if that is not an order of 1..size
+void ContractionHierarchy::setRanks() {
+    rank.assign(size + 1, -1);
+    for (int i = 0; i < size; ++i) {
+        const int v = contraction_order[i];
+        if (v < 1 || v > size || rank[v] != -1) {
+            rank.clear();
+            return;
+        }
+        rank[v] = i;
+    }
+}
+
+// fill in_edges from up and down
+void ContractionHierarchy::setInEdges() {
+    // The edges of the digraph are the ones that skip no vertex, stored as (v, u) to be found at v
+    std::vector<Edge> E;
+    for (int v = 1; v <= size; ++v) {
+        for (int i = up.first(v); i < up.last(v); ++i) {
+            if (up_via[i] == 0) E.emplace_back(up.targets[i], v, up.weights[i]);
+        }
+        for (int i = down.first(v); i < down.last(v); ++i) {
+            if (down_via[i] == 0) E.emplace_back(v, down.targets[i], down.weights[i]);
+        }
+    }
+
+    // Of repeated edges only the shortest can be on a shortest path
+    std::sort(E.begin(), E.end(), [](const Edge& a, const Edge& b) {
+        return std::tie(a.from, a.to, a.weight) < std::tie(b.from, b.to, b.weight);
+    });
+    E.erase(std::unique(E.begin(), E.end(), [](const Edge& a, const Edge& b) { return a.links_same_nodes(b); }),
+            E.end());
+    in_edges = CSR{E, size};
+}
@@ -0,0 +1,86 @@
+/*********************************************
+ * file:	~\code4a\hierarchy.h              *
+ * remark: contraction hierarchy of a digraph *
+ **********************************************/
+
+#pragma once
+
+#include <vector>
+#include <filesystem>
+
+#include "csr.h"
+#include "digraph.h"
+
+/*
+ * Contraction hierarchy of a digraph with positive weights, for fast repeated point-to-point queries
+ * Preprocessing removes the vertices one by one, least important first. When a vertex v is removed, a shortcut
+ * (u, w) with the length of u -> v -> w is added for every pair of neighbours whose shortest path goes
+ * through v. A query then searches from s only towards vertices removed later, and finds the distance of a
+ * vertex from the distances of the vertices removed after it, which reaches a few thousand vertices instead of
+ * the whole graph.
+ * The hierarchy is a snapshot: it does not see later changes of the digraph.
+ */
+class ContractionHierarchy {
+public:
+    // -- CONSTRUCTORS
+    ContractionHierarchy() = default;
+
+    // Build the hierarchy of G, this can take a while for large graphs
+    explicit ContractionHierarchy(const Digraph& G);
+
+    // -- MEMBER FUNCTIONS
+
+    // shortest positive weighted path from s to t, the same path pwtree finds: of several shortest paths to a
+    // vertex the one through the smallest previous vertex is chosen
+    // any number of threads can run queries at the same time
+    PathResult path(int s, int t) const;
+
+    // number of vertices
+    int vertices() const {
+        return size;
+    }
+
+    // number of edges of the hierarchy, original edges and shortcuts
+    int edges() const {
+        return up.edges() + down.edges();
+    }
+
+    // the vertices in the order they were removed, least important first
+    const std::vector<int>& order() const {
+        return contraction_order;
+    }
+
+    // Store the hierarchy in a binary file, throws std::runtime_error if the file can not be written
+    void save(const std::filesystem::path& file) const;
+
+    // Read a hierarchy written by save(), throws std::runtime_error if the file can not be read
+    static ContractionHierarchy load(const std::filesystem::path& file);
+
+private:
+    // distance from s to v, given the search from s towards vertices removed later in upward
+    // the distances of v and of the vertices removed after it are kept in known, returns the number added
+    int sweep(int v, const Workspace& upward, Workspace& known) const;
+
+    // fill rank from contraction_order
+    void setRanks();
+
+    // fill in_edges from up and down
+    void setInEdges();
+
+    // -- DATA MEMBERS
+    int size{0};                         // number of vertices
+    std::vector<int> contraction_order;  // vertices, least important first
+    std::vector<int> rank;               // position of every vertex in contraction_order
+
+    // up: the edges (v, w) with w removed after v, stored at v
+    // down: the edges (u, v) with u removed after v, stored at v with target u
+    // The edges of every vertex are sorted by target. via is the vertex a shortcut skips, 0 for an edge of the digraph
+    CSR up;
+    std::vector<int> up_via;
+    CSR down;
+    std::vector<int> down_via;
+
+    // the edges (u, v) of the digraph in up and down, stored at v with target u, sorted by target
+    // Every edge on a shortest path is kept, a shortcut only replaces a longer edge
+    CSR in_edges;
+};
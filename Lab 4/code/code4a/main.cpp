@@ -6,12 +6,49 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <string_view>
 #include <cstdlib>  // std::atoi
 #include <vector>
+#include <algorithm>  // std::max
 #include <memory>  // std::unique_ptr
 #include <cassert>
+#include <stdexcept>
+#include <filesystem>
+#include <chrono>
+#include <charconv>  // std::from_chars
+#include <sstream>
+#include <span>
+#include <iterator>  // std::back_inserter
+#include <format>
 
 #include "digraph.h"
+#include "hierarchy.h"
+#include "graphfile.h"
+
+/*
+ * Without arguments the program shows the menu. With arguments it runs a batch of commands on one graph
+ * and prints a JSON object per line, for scripts and benchmarks:
+ *
+ *   Lab4a [--trees] [--threads <t>] [--verify] <graph file> [-f <command file>] [<command>...]
+ *     --trees    also print the dist and parent arrays of uwsssp and pwsssp
+ *     --threads  threads of the parallel searches, default one per hardware thread
+ *     --verify   check every edge of a binary graph file (.csr), see verifyGraphFile. Without it the edges are
+ *                used unchecked, so unverified files must come from Lab4Convert or pass Lab4Convert --verify
+ *     -f         read commands from a file, separated by white space, # starts a comment
+ *
+ *   commands: uwsssp <s>, pwsssp <s>, uwpath <s> <t>, pwpath <s> <t>,
+ *             chbuild <file>, chload <file>, chpath <s> <t>, chcheck <s>
+ *
+ * The graph file is opened as given, not relative to ../code/code4a/. The first line describes the
+ * loaded graph, every command adds a line with its results and the time it took in ms, e.g.
+ *   {"command":"pwpath","source":1,"target":5,"distance":6,"path":[1,4,5],"settled":4,"ms":0.012}
+ * A command with a vertex not in the graph prints a line with "error" instead.
+ * The first uwpath or pwpath also builds the reversed adjacency of the graph, which the later ones reuse.
+ *
+ * chbuild builds the contraction hierarchy of the graph (see hierarchy.h) and stores it in a file, chload reads
+ * a stored one instead. chpath answers pwpath with the hierarchy. chcheck runs chpath from s to every vertex,
+ * compares the results with the tree of pwsssp and prints the number of vertices whose distance or path differs.
+ */
 
 // -- FUNCTION DECLARATIONS
 
@@ -23,9 +60,22 @@ int menu();
 // Return a pointer to the graph
 std::unique_ptr<Digraph> readGraph(const std::string& fileName);
 
+// Read a text graph file or map a binary graph file (see graphfile.h) and create the graph
+// The edges of a binary graph file are only checked if verify is set
+// throws std::runtime_error if the file can not be read
+std::unique_ptr<Digraph> loadGraph(const std::filesystem::path& file, bool verify = false);
+
+// print the path of a point-to-point query and the corresponding path length
+void printPath(const PathResult& result);
+
+// run the commands given by the program arguments, see above
+int runCommands(const std::vector<std::string_view>& args);
+
 // -- MAIN PROGRAM
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1) return runCommands({argv + 1, argv + argc});
+
     int choice{0};
     std::string fileName;
     int s{0};
@@ -43,11 +93,19 @@ int main() {
                 break;
             case 2:
                 s = readInt("Source s    ? ");
-                if (G) G->uwsssp(s);
+                if (G) {
+                    G->uwsssp(s);
+                    std::cout << "\n";
+                    G->printTree();
+                }
                 break;
             case 3:
                 s = readInt("Source s    ? ");
-                if (G) G->pwsssp(s);
+                if (G) {
+                    G->pwsssp(s);
+                    std::cout << "\n";
+                    G->printTree();
+                }
                 break;
             case 4:
                 std::cout << "\n";
@@ -62,6 +120,12 @@ int main() {
                 std::cout << "\nShortest path =";
                 if (G) G->printPath(t);
                 break;
+            case 7:
+                s = readInt("Source s    ? ");
+                t = readInt("Target t    ? ");
+                std::cout << "\nShortest path =";
+                if (G) printPath(G->pwpath(s, t));
+                break;
             case 9:
                 std::cout << "Bye bye ...\n";
                 break;
@@ -91,6 +155,7 @@ int menu() {
     std::cout << "4. printGraph  \n";
     std::cout << "5. printTree   \n";
     std::cout << "6. printPath   \n";
+    std::cout << "7. pwpath      \n";
     std::cout << "9. quit        \n";
     std::cout << "===============\n";
 
@@ -100,15 +165,30 @@ int menu() {
 // Read a graph's data from a file and create the graph
 // Return a pointer to the graph
 std::unique_ptr<Digraph> readGraph(const std::string& fileName) {
-    std::ifstream file{"../code/code4a/" + fileName};  // modify the file path, if needed (Mac)
-
-    if (!file) {
-        std::cout << "File not found!\n";
+    try {
+        return loadGraph("../code/code4a/" + fileName, true);  // modify the file path, if needed (Mac)
+    } catch (const std::runtime_error& e) {
+        std::cout << e.what() << "\n";
         return nullptr;
     }
+}
+
+// Read a text graph file or map a binary graph file and create the graph
+std::unique_ptr<Digraph> loadGraph(const std::filesystem::path& file, bool verify) {
+    // Binary graph files, see graphfile.h, are mapped instead of read
+    if (file.extension() == ".csr") {
+        return std::unique_ptr<Digraph>{new Digraph{verify ? verifyGraphFile(file) : mapGraphFile(file)}};
+    }
+
+    std::ifstream in{file};
+
+    if (!in) {
+        throw std::runtime_error(std::format("File {} not found!", file.string()));
+    }
 
     int n{0};
-    file >> n;  // read number of vertices
+    in >> n;  // read number of vertices
+    if (n < 1) throw std::runtime_error(std::format("{} is not a graph file", file.string()));
 
     std::vector<Edge> E{};  // to store the edges
     int u{0};
@@ -116,9 +196,261 @@ std::unique_ptr<Digraph> readGraph(const std::string& fileName) {
     int w{0};
 
     // Read all edges
-    while (file >> u >> v >> w) {
+    while (in >> u >> v >> w) {
         // std::cout << u << " " << v << " " << w << '\n';
         E.push_back({u, v, w});
     }
-    return std::unique_ptr<Digraph>{new Digraph{E, n}};
+
+    // The adjacency is built here rather than by the first query, so that the queries can be timed
+    return std::unique_ptr<Digraph>{new Digraph{fileAdjacency(E, n)}};
+}
+
+// print the path of a point-to-point query and the corresponding path length
+void printPath(const PathResult& result) {
+    for (int v : result.path) {
+        std::cout << " " << v << "  ";
+    }
+    std::cout << "(" << result.distance << ")\n";
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// A command and its vertices
+struct Command {
+    std::string name;
+    std::vector<int> vertices;
+    std::string file;  // hierarchy file of chbuild and chload
+};
+
+// number of vertices every command takes, -1 for an unknown command
+int arity(std::string_view name) {
+    if (name == "uwsssp" || name == "pwsssp" || name == "chcheck") return 1;
+    if (name == "uwpath" || name == "pwpath" || name == "chpath") return 2;
+    if (name == "chbuild" || name == "chload") return 0;
+    return -1;
+}
+
+// true for the commands that take a file
+bool takesFile(std::string_view name) {
+    return name == "chbuild" || name == "chload";
+}
+
+// Split the commands in words into Commands, throws std::runtime_error for unknown commands or missing vertices
+std::vector<Command> parseCommands(const std::vector<std::string>& words) {
+    std::vector<Command> commands;
+    for (std::size_t i = 0; i < words.size();) {
+        Command command{words[i++], {}, {}};
+        const int count = arity(command.name);
+        if (count < 0) throw std::runtime_error(std::format("unknown command {}", command.name));
+
+        for (int k = 0; k < count; ++k, ++i) {
+            int v = 0;
+            const char* first = (i < words.size()) ? words[i].data() : nullptr;
+            const char* last = (i < words.size()) ? first + words[i].size() : nullptr;
+            if (!first || std::from_chars(first, last, v).ptr != last || first == last) {
+                throw std::runtime_error(std::format("{} needs {} vertices", command.name, count));
+            }
+            command.vertices.push_back(v);
+        }
+        if (takesFile(command.name)) {
+            if (i == words.size()) throw std::runtime_error(std::format("{} needs a file", command.name));
+            command.file = words[i++];
+        }
+        commands.push_back(std::move(command));
+    }
+    return commands;
+}
+
+// Append the words of a command file, # starts a comment
+void readCommandFile(const std::string& file, std::vector<std::string>& words) {
+    std::ifstream in{file};
+    if (!in) throw std::runtime_error(std::format("File {} not found!", file));
+
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream words_of_line{line.substr(0, line.find('#'))};
+        for (std::string word; words_of_line >> word;) {
+            words.push_back(word);
+        }
+    }
+}
+
+// text as a JSON string
+std::string json(std::string_view text) {
+    std::string result{"\""};
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            result += std::format("\\u{:04x}", c);
+        } else {
+            result += c;
+        }
+    }
+    return result + "\"";
+}
+
+// numbers as a JSON array
+std::string json(std::span<const int> numbers) {
+    std::string result{"["};
+    for (std::size_t i = 0; i < numbers.size(); ++i) {
+        std::format_to(std::back_inserter(result), "{}{}", (i > 0) ? "," : "", numbers[i]);
+    }
+    return result + "]";
+}
+
+// Run a command of the contraction hierarchy of G and return its JSON object
+// chbuild and chload replace the hierarchy, the other commands need one
+std::string runHierarchyCommand(const Digraph& G, const Command& command, unsigned threads,
+                                std::unique_ptr<ContractionHierarchy>& hierarchy) {
+    const std::string name = json(command.name);
+    const auto start = Clock::now();
+
+    if (takesFile(command.name)) {
+        try {
+            if (command.name == "chbuild") {
+                hierarchy = std::make_unique<ContractionHierarchy>(G);
+                hierarchy->save(command.file);
+            } else {
+                auto H = std::make_unique<ContractionHierarchy>(ContractionHierarchy::load(command.file));
+                if (H->vertices() != G.vertices()) {
+                    throw std::runtime_error(std::format("{} has {} vertices, the graph has {}", command.file,
+                                                         H->vertices(), G.vertices()));
+                }
+                hierarchy = std::move(H);
+            }
+        } catch (const std::runtime_error& e) {
+            return std::format("{{\"command\":{},\"error\":{}}}", name, json(e.what()));
+        }
+        return std::format("{{\"command\":{},\"file\":{},\"vertices\":{},\"edges\":{},\"ms\":{:.3f}}}", name,
+                           json(command.file), hierarchy->vertices(), hierarchy->edges(), millisecondsSince(start));
+    }
+
+    if (!hierarchy) {
+        return std::format("{{\"command\":{},\"error\":\"no contraction hierarchy, run chbuild or chload\"}}",
+                           name);
+    }
+
+    const int s = command.vertices[0];
+    if (command.name == "chpath") {
+        const int t = command.vertices[1];
+        const PathResult P = hierarchy->path(s, t);
+        const double ms = millisecondsSince(start);
+        return std::format("{{\"command\":{},\"source\":{},\"target\":{},\"distance\":{},\"path\":{},"
+                           "\"settled\":{},\"ms\":{:.3f}}}",
+                           name, s, t, P.distance, json(P.path), P.settled, ms);
+    }
+
+    // chcheck: the path to every vertex is the one in the tree of pwtree
+    const PathTree T = G.pwtree(s, threads);
+    int mismatches = 0;
+    for (int t = 1; t <= G.vertices(); ++t) {
+        std::vector<int> expected;
+        for (int v = t; T.dist[t] >= 0 && v != 0; v = T.path[v]) {
+            expected.push_back(v);
+        }
+        std::reverse(expected.begin(), expected.end());
+
+        const PathResult P = hierarchy->path(s, t);
+        mismatches += (P.distance != T.dist[t] || P.path != expected);
+    }
+    return std::format("{{\"command\":{},\"source\":{},\"vertices\":{},\"mismatches\":{},\"ms\":{:.3f}}}",
+                       name, s, G.vertices(), mismatches, millisecondsSince(start));
+}
+
+// Run one command on G and return its JSON object
+std::string runCommand(const Digraph& G, const Command& command, unsigned threads, bool trees,
+                       std::unique_ptr<ContractionHierarchy>& hierarchy) {
+    const std::string name = json(command.name);
+    for (int v : command.vertices) {
+        if (v < 1 || v > G.vertices()) {
+            return std::format("{{\"command\":{},\"error\":\"vertex {} is not in the graph\"}}", name, v);
+        }
+    }
+    if (command.name.starts_with("ch")) return runHierarchyCommand(G, command, threads, hierarchy);
+
+    const int s = command.vertices[0];
+    const auto start = Clock::now();
+    if (command.vertices.size() == 1) {
+        const PathTree T = (command.name == "uwsssp") ? G.uwtree(s, threads) : G.pwtree(s, threads);
+        const double ms = millisecondsSince(start);
+
+        // The tree and the largest distance in it
+        int reached = 0;
+        int farthest = 0;
+        for (int d : std::span{T.dist}.subspan(1)) {
+            reached += (d >= 0);
+            farthest = std::max(farthest, d);
+        }
+        std::string result = std::format("{{\"command\":{},\"source\":{},\"reached\":{},\"max_distance\":{}", name,
+                                         s, reached, farthest);
+        if (trees) {
+            result += std::format(",\"dist\":{},\"parent\":{}", json(std::span{T.dist}.subspan(1)),
+                                  json(std::span{T.path}.subspan(1)));
+        }
+        return result + std::format(",\"ms\":{:.3f}}}", ms);
+    }
+
+    const int t = command.vertices[1];
+    const PathResult P = (command.name == "uwpath") ? G.uwpath(s, t) : G.pwpath(s, t);
+    const double ms = millisecondsSince(start);
+    return std::format("{{\"command\":{},\"source\":{},\"target\":{},\"distance\":{},\"path\":{},\"settled\":{},"
+                       "\"ms\":{:.3f}}}",
+                       name, s, t, P.distance, json(P.path), P.settled, ms);
+}
+
+}  // namespace
+
+// run the commands given by the program arguments
+int runCommands(const std::vector<std::string_view>& args) try {
+    bool trees = false;
+    bool verify = false;
+    unsigned threads = 0;
+    std::string graphFile;
+    std::vector<std::string> words;
+
+    for (std::size_t i = 0; i < args.size(); ++i) {
+        const bool hasValue = i + 1 < args.size();
+        if (args[i] == "--trees") {
+            trees = true;
+        } else if (args[i] == "--verify") {
+            verify = true;
+        } else if (args[i] == "--threads" && hasValue) {
+            threads = static_cast<unsigned>(std::max(std::atoi(std::string{args[++i]}.c_str()), 0));
+        } else if (args[i] == "-f" && hasValue) {
+            readCommandFile(std::string{args[++i]}, words);
+        } else if (graphFile.empty()) {
+            graphFile = args[i];
+        } else {
+            words.emplace_back(args[i]);
+        }
+    }
+    if (graphFile.empty()) {
+        throw std::runtime_error(
+            "Usage: Lab4a [--trees] [--threads <t>] [--verify] <graph file> [-f <command file>] [<command>...]");
+    }
+
+    // All commands are checked before the graph is read
+    const std::vector<Command> commands = parseCommands(words);
+
+    const auto start = Clock::now();
+    const std::unique_ptr<Digraph> G = loadGraph(graphFile, verify);
+    std::cout << std::format("{{\"command\":\"load\",\"file\":{},\"vertices\":{},\"edges\":{},\"ms\":{:.3f}}}\n",
+                             json(graphFile), G->vertices(), G->edges(), millisecondsSince(start));
+
+    std::unique_ptr<ContractionHierarchy> hierarchy;
+    for (auto const& command : commands) {
+        std::cout << runCommand(*G, command, threads, trees, hierarchy) << "\n";
+    }
+    return 0;
+} catch (const std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return 1;
 }
@@ -0,0 +1,73 @@
+/*********************************************
+ * file:	~\code4a\workspace.h              *
+ * remark: reusable state of path searches    *
+ **********************************************/
+
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+// Distances, parents and done flags of one path search over vertices 1..n
+// Every entry carries the version of the search that wrote it, so reset() forgets all entries in O(1)
+// and a search only pays for the vertices it touches
+class Workspace {
+public:
+    static constexpr int infinity = std::numeric_limits<int>::max();
+
+    // -- MEMBER FUNCTIONS
+
+    // start a new search on a graph with n vertices
+    void reset(int n) {
+        if (std::ssize(stamp) < n + 1) {
+            stamp.resize(n + 1, 0);
+            done_stamp.resize(n + 1, 0);
+            distance.resize(n + 1);
+            parent.resize(n + 1);
+        }
+        if (++version == 0) {  // wrapped around, old stamps could look current
+            std::fill(stamp.begin(), stamp.end(), 0);
+            std::fill(done_stamp.begin(), done_stamp.end(), 0);
+            version = 1;
+        }
+    }
+
+    // distance of v, infinity if v was not reached
+    int dist(int v) const {
+        return (stamp[v] == version) ? distance[v] : infinity;
+    }
+
+    // previous vertex on the path to v, 0 if v was not reached or is the start
+    int path(int v) const {
+        return (stamp[v] == version) ? parent[v] : 0;
+    }
+
+    // true if the distance of v is final
+    bool done(int v) const {
+        return done_stamp[v] == version;
+    }
+
+    // reach v with distance d from previous vertex p
+    void set(int v, int d, int p) {
+        stamp[v] = version;
+        distance[v] = d;
+        parent[v] = p;
+    }
+
+    // mark the distance of v as final
+    void setDone(int v) {
+        done_stamp[v] = version;
+    }
+
+    // -- DATA MEMBERS
+    unsigned long long owner{0};  // id of the graph of the last search, 0 if none
+    int source{0};                // start vertex of the last search
+
+private:
+    std::vector<unsigned> stamp;
+    std::vector<unsigned> done_stamp;
+    std::vector<int> distance;
+    std::vector<int> parent;
+    unsigned version{0};
+};
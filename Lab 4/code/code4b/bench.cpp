@@ -0,0 +1,149 @@
+/*********************************************
+ * file:	~\code4b\bench.cpp                *
+ * remark: minimum spanning tree algorithms   *
+ **********************************************/
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <cstdlib>  // std::atoi, std::atoll
+#include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <utility>  // std::pair
+#include <stdexcept>
+#include <format>
+
+#include "graph.h"
+#include "graphfile.h"
+
+/*
+ * Benchmark of Prim's, Kruskal's, Filter-Kruskal and Boruvka's minimum spanning tree algorithms
+ *
+ * Usage: Lab4bBench [--edges <m1,m2,...>] [--degree <d>] [--weights <w>] [--threads <t>] [--seed <s>]
+ *   --edges    number of edges of every generated graph, default 1000000,3000000,10000000
+ *   --degree   average degree, the graph has 2 * edges / degree vertices, default 8
+ *   --weights  edge weights are drawn uniformly from 1..w, default 100
+ *   --threads  threads used by Boruvka's algorithm, default one per hardware thread
+ *
+ * Every graph is a random tree, so that it is connected, plus random edges with uniformly chosen end points.
+ * Every algorithm is checked against the total weight of Kruskal's algorithm.
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::vector<long long> edges{1'000'000, 3'000'000, 10'000'000};
+    int degree = 8;
+    int weights = 100;
+    unsigned threads = 0;
+    unsigned long long seed = 2024;
+};
+
+std::vector<long long> parseList(std::string_view list) {
+    std::vector<long long> values;
+    while (!list.empty()) {
+        const auto comma = list.find(',');
+        values.push_back(std::atoll(std::string{list.substr(0, comma)}.c_str()));
+        list = (comma == std::string_view::npos) ? std::string_view{} : list.substr(comma + 1);
+    }
+    return values;
+}
+
+Options parseArguments(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--edges" && hasValue) {
+            options.edges = parseList(argv[++i]);
+            std::erase_if(options.edges, [](long long m) { return m <= 0; });
+        } else if (arg == "--degree" && hasValue) {
+            options.degree = std::max(std::atoi(argv[++i]), 2);
+        } else if (arg == "--weights" && hasValue) {
+            options.weights = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "--threads" && hasValue) {
+            options.threads = static_cast<unsigned>(std::max(std::atoi(argv[++i]), 0));
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = static_cast<unsigned long long>(std::atoll(argv[++i]));
+        } else {
+            throw std::runtime_error(std::format("unknown option {}", arg));
+        }
+    }
+    return options;
+}
+
+// A connected graph with n vertices and m undirected edges, both directions of every edge are in the adjacency
+CSR generateGraph(int n, long long m, int weights, std::mt19937_64& random) {
+    std::uniform_int_distribution<int> weight(1, weights);
+
+    std::vector<Edge> V;
+    V.reserve(2 * m);
+    auto add = [&V, &weight, &random](int u, int v) {
+        const Edge e{u, v, weight(random)};
+        V.push_back(e);
+        V.push_back(e.reverse());
+    };
+
+    // A random tree: every vertex is joined to one of the vertices before it
+    for (int v = 2; v <= n; ++v) {
+        add(v, std::uniform_int_distribution<int>(1, v - 1)(random));
+    }
+
+    std::uniform_int_distribution<int> vertex(1, n);
+    while (std::ssize(V) < 2 * m) {
+        const int u = vertex(random);
+        const int v = vertex(random);
+        if (u != v) add(u, v);
+    }
+    return fileAdjacency(V, n);
+}
+
+double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+}  // namespace
+
+/* ************************************* */
+
+int main(int argc, char* argv[]) try {
+    const Options options = parseArguments(argc, argv);
+    std::mt19937_64 random(options.seed);
+
+    const std::vector<std::pair<std::string, std::function<SpanningTree(const Graph&)>>> algorithms{
+        {"prim_ms", [](const Graph& G) { return G.mstPrim(); }},
+        {"kruskal_ms", [](const Graph& G) { return G.mstKruskal(); }},
+        {"filter_ms", [](const Graph& G) { return G.mstKruskal(Graph::KruskalMethod::Filter); }},
+        {"boruvka_ms", [&options](const Graph& G) { return G.mstBoruvka(options.threads); }},
+    };
+
+    std::cout << std::format("{:>10} {:>9}", "edges", "vertices");
+    for (auto const& [name, algorithm] : algorithms) {
+        std::cout << std::format(" {:>12}", name);
+    }
+    std::cout << std::format(" {:>6}\n", "check");
+
+    for (long long m : options.edges) {
+        const int n = static_cast<int>(std::clamp(2 * m / options.degree, 2LL, m + 1));
+        const Graph G{generateGraph(n, m, options.weights, random)};
+        const long long weight = G.mstKruskal().weight;
+
+        std::cout << std::format("{:>10} {:>9}", m, n);
+        bool same = true;
+        for (auto const& [name, algorithm] : algorithms) {
+            const auto start = Clock::now();
+            const SpanningTree T = algorithm(G);
+            std::cout << std::format(" {:>12.2f}", millisecondsSince(start));
+            same = same && (T.weight == weight) && (std::ssize(T.edges) == n - 1);
+        }
+        std::cout << std::format(" {:>6}\n", same ? "ok" : "FAIL");
+    }
+} catch (const std::exception& e) {
+    std::cout << std::format("Error: {}\n", e.what());
+    return 1;
+}
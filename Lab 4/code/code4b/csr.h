@@ -0,0 +1,161 @@
+/*********************************************
+ * file:	~\code4b\csr.h                    *
+ * remark: compressed sparse row adjacency    *
+ **********************************************/
+
+#pragma once
+
+#include <list>
+#include <vector>
+#include <span>
+#include <memory>  // std::shared_ptr
+#include <algorithm>
+#include <iterator>
+#include <cassert>
+#include <stdexcept>
+#include <format>
+
+#include "edge.h"
+
+// Immutable adjacency of a graph with vertices 1..n stored in three flat arrays
+// The edges leaving vertex v are (v, targets[i], weights[i]) for i in [first(v), last(v))
+// The arrays are shared by all copies, they are either owned or a view of e.g. a mapped graph file
+class CSR {
+public:
+    // -- CONSTRUCTORS
+    CSR() = default;
+
+    // Build from a table of adjacency lists, slot zero not used
+    // The edges of every vertex keep the order of its list
+    explicit CSR(const std::vector<std::list<Edge>>& table) {
+        std::vector<int> o(table.size() + 1, 0);
+        for (std::size_t v = 0; v < table.size(); ++v) {
+            o[v + 1] = o[v] + static_cast<int>(table[v].size());
+        }
+
+        std::vector<int> t;
+        std::vector<int> w;
+        t.reserve(o.back());
+        w.reserve(o.back());
+        for (auto const& edges : table) {
+            for (auto const& e : edges) {
+                t.push_back(e.to);
+                w.push_back(e.weight);
+            }
+        }
+        adopt(std::move(o), std::move(t), std::move(w));
+    }
+
+    // Build from the edges in V of a graph with n vertices
+    // Edges (u, v) given more than once are stored once, with the weight given last (see uniqueEdges), and the
+    // edges of every vertex keep the order in which they first appear in V, as in the adjacency lists
+    // throws std::runtime_error if an edge has a vertex outside 1..n
+    CSR(const std::vector<Edge>& V, int n) {
+        const std::vector<Edge> E = uniqueEdges(V);
+
+        // Counting sort on the start vertex, stable so that the input order is kept for every vertex
+        std::vector<int> o(n + 2, 0);
+        for (auto const& e : E) {
+            if (e.from < 1 || e.from > n || e.to < 1 || e.to > n) {
+                throw std::runtime_error(std::format("edge ({}, {}) has no vertex in 1..{}", e.from, e.to, n));
+            }
+            ++o[e.from + 1];
+        }
+        for (int v = 1; v <= n + 1; ++v) {
+            o[v] += o[v - 1];
+        }
+
+        std::vector<int> t(E.size());
+        std::vector<int> w(E.size());
+        std::vector<int> next(o.begin(), o.end() - 1);
+        for (auto const& e : E) {
+            const int i = next[e.from]++;
+            t[i] = e.to;
+            w[i] = e.weight;
+        }
+        adopt(std::move(o), std::move(t), std::move(w));
+    }
+
+    // Take over ready made arrays, offsets has n + 2 entries for a graph with n vertices
+    CSR(std::vector<int> offsets, std::vector<int> targets, std::vector<int> weights) {
+        assert(targets.size() == weights.size() && !offsets.empty() && offsets.back() == std::ssize(targets));
+        adopt(std::move(offsets), std::move(targets), std::move(weights));
+    }
+
+    // View arrays that live in storage, which is kept alive as long as any copy of the CSR
+    CSR(std::shared_ptr<const void> storage, std::span<const int> offsets, std::span<const int> targets,
+        std::span<const int> weights)
+        : offsets{offsets}, targets{targets}, weights{weights}, storage{std::move(storage)} {
+    }
+
+    // -- MEMBER FUNCTIONS
+
+    // index of the first edge leaving v
+    int first(int v) const {
+        return offsets[v];
+    }
+
+    // index past the last edge leaving v
+    int last(int v) const {
+        return offsets[v + 1];
+    }
+
+    // number of edges leaving v
+    int degree(int v) const {
+        return offsets[v + 1] - offsets[v];
+    }
+
+    // total number of edges
+    int edges() const {
+        return static_cast<int>(targets.size());
+    }
+
+    // the same graph with every edge (u, v) turned into (v, u)
+    // if forward is given, (*forward)[j] is set to the index in this CSR of edge j of the result
+    CSR reversed(std::vector<int>* forward = nullptr) const {
+        std::vector<int> o(offsets.size(), 0);
+        std::vector<int> t(targets.size());
+        std::vector<int> w(weights.size());
+
+        const int n = static_cast<int>(offsets.size()) - 2;
+        for (int u : targets) {
+            ++o[u + 1];
+        }
+        for (int v = 1; v <= n + 1; ++v) {
+            o[v] += o[v - 1];
+        }
+
+        if (forward) forward->resize(targets.size());
+
+        std::vector<int> next(o.begin(), o.end() - 1);
+        for (int v = 1; v <= n; ++v) {
+            for (int i = first(v); i < last(v); ++i) {
+                const int j = next[targets[i]]++;
+                t[j] = v;
+                w[j] = weights[i];
+                if (forward) (*forward)[j] = i;
+            }
+        }
+        return {std::move(o), std::move(t), std::move(w)};
+    }
+
+    // -- DATA MEMBERS
+    std::span<const int> offsets;  // offsets[v] is the index of the first edge leaving v
+    std::span<const int> targets;  // end vertex of every edge
+    std::span<const int> weights;  // weight of every edge
+
+private:
+    // own the given arrays
+    void adopt(std::vector<int> o, std::vector<int> t, std::vector<int> w) {
+        struct Arrays {
+            std::vector<int> offsets, targets, weights;
+        };
+        auto arrays = std::make_shared<const Arrays>(std::move(o), std::move(t), std::move(w));
+        offsets = arrays->offsets;
+        targets = arrays->targets;
+        weights = arrays->weights;
+        storage = std::move(arrays);
+    }
+
+    std::shared_ptr<const void> storage;  // owner of the arrays
+};
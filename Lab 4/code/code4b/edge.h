@@ -8,6 +8,10 @@
 #include <iostream>
 #include <format>
 #include <compare>  // three-way comparison operator <=>
+#include <vector>
+#include <algorithm>
+#include <numeric>  // std::iota
+#include <tuple>    // std::tie
 
 // Represents a directed edge 'from' 'head 'to' with weight
 class Edge {
@@ -40,3 +44,33 @@ public:
     int to;
     int weight;
 };
+
+// Returns the edges in V without repeated edges (u, v), in the order each edge first appears in V
+// A repeated edge gets the weight it is given last, as if all edges were inserted one by one
+// Time complexity: O(E log E), instead of a search in the adjacency list for every edge
+inline std::vector<Edge> uniqueEdges(const std::vector<Edge>& V) {
+    std::vector<int> order(V.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    // Group equal edges, in input order within a group
+    std::sort(order.begin(), order.end(), [&V](int a, int b) {
+        return std::tie(V[a].from, V[a].to, a) < std::tie(V[b].from, V[b].to, b);
+    });
+
+    // Mark the first appearance of every edge and give it the last weight
+    std::vector<bool> keep(V.size(), false);
+    std::vector<int> weight(V.size(), 0);
+    for (std::size_t i = 0; i < order.size();) {
+        std::size_t j = i;
+        while (j < order.size() && V[order[j]].links_same_nodes(V[order[i]])) ++j;
+        keep[order[i]] = true;
+        weight[order[i]] = V[order[j - 1]].weight;
+        i = j;
+    }
+
+    std::vector<Edge> E;
+    for (std::size_t i = 0; i < V.size(); ++i) {
+        if (keep[i]) E.push_back({V[i].from, V[i].to, weight[i]});
+    }
+    return E;
+}
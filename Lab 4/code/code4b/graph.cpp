@@ -9,12 +9,207 @@
 #include <cassert>     // assert
 #include <limits>      // std::numeric_limits
 #include <algorithm>   // std::make_heap(), std::pop_heap(), std::push_heap()
+#include <iterator>    // std::prev
+#include <numeric>     // std::iota
+#include <array>
+#include <span>
+#include <random>      // std::minstd_rand
+#include <thread>
+#include <atomic>
+#include <cstdint>     // std::uint64_t
+#include <utility>     // std::pair, std::swap
 
 #include "graph.h"
 #include "dsets.h"
 
 // Note: graph vertices are numbered from 1 -- i.e. there is no vertex zero
 
+namespace {
+
+// Filter-Kruskal sorts parts with at most this many edges instead of splitting them further
+constexpr std::size_t filter_kruskal_min_edges = 1024;
+
+// Boruvka's algorithm runs on one thread for graphs with fewer edges, where starting threads costs more than it saves
+constexpr int parallel_min_edges = 1 << 16;
+
+// Min-heap of vertices 1..n ordered by their keys, the smaller vertex first among equal keys
+// Every vertex knows its position in the heap, so its key can be lowered in O(log n)
+class IndexedHeap {
+public:
+    explicit IndexedHeap(int n) : position(n + 1, absent), key(n + 1, 0) {
+    }
+
+    bool empty() const {
+        return heap.empty();
+    }
+
+    // insert v with key k, or lower the key of v to k if v is in the heap
+    void push(int v, int k) {
+        key[v] = k;
+        if (position[v] == absent) {
+            position[v] = static_cast<int>(heap.size());
+            heap.push_back(v);
+        }
+        siftUp(position[v]);
+    }
+
+    // remove and return the vertex with the smallest key
+    int pop() {
+        const int v = heap.front();
+        position[v] = absent;
+        const int last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) {
+            place(0, last);
+            siftDown(0);
+        }
+        return v;
+    }
+
+private:
+    static constexpr int absent = -1;
+
+    bool before(int u, int v) const {
+        return key[u] < key[v] || (key[u] == key[v] && u < v);
+    }
+
+    void place(int i, int v) {
+        heap[i] = v;
+        position[v] = i;
+    }
+
+    void siftUp(int i) {
+        const int v = heap[i];
+        while (i > 0 && before(v, heap[(i - 1) / 2])) {
+            place(i, heap[(i - 1) / 2]);
+            i = (i - 1) / 2;
+        }
+        place(i, v);
+    }
+
+    void siftDown(int i) {
+        const int v = heap[i];
+        const int n = static_cast<int>(heap.size());
+        while (2 * i + 1 < n) {
+            int child = 2 * i + 1;
+            if (child + 1 < n && before(heap[child + 1], heap[child])) ++child;
+            if (!before(heap[child], v)) break;
+            place(i, heap[child]);
+            i = child;
+        }
+        place(i, v);
+    }
+
+    // -- DATA MEMBERS
+    std::vector<int> heap;      // the vertices in heap order
+    std::vector<int> position;  // position[v] is the index of v in heap, absent if v is not in the heap
+    std::vector<int> key;       // key of every vertex in the heap
+};
+
+// Sort E by weight, edges of equal weight keep their order
+// LSD radix sort on the weight minus the smallest weight, 8 bits per pass, so weights below 256 need one pass
+void sortByWeight(std::span<Edge> E) {
+    if (E.empty()) return;
+
+    const auto [lightest, heaviest] = std::ranges::minmax_element(E, {}, &Edge::weight);
+    const auto offset = static_cast<unsigned>(lightest->weight);
+    const unsigned range = static_cast<unsigned>(heaviest->weight) - offset;
+
+    // The passes alternate between E and buffer
+    std::vector<Edge> buffer(E.size());
+    std::span<Edge> sorted = buffer;
+    for (int shift = 0; shift < 32 && (range >> shift) != 0; shift += 8) {
+        auto digit = [offset, shift](const Edge &e) {
+            return ((static_cast<unsigned>(e.weight) - offset) >> shift) & 0xFF;
+        };
+
+        // start[d] is the position of the first edge with digit d
+        std::array<std::size_t, 257> start{};
+        for (auto const &e : E) {
+            ++start[digit(e) + 1];
+        }
+        for (std::size_t d = 1; d < start.size(); ++d) {
+            start[d] += start[d - 1];
+        }
+        for (auto const &e : E) {
+            sorted[start[digit(e)]++] = e;
+        }
+        std::swap(E, sorted);
+    }
+    if (E.data() == buffer.data()) std::ranges::copy(E, sorted.begin());
+}
+
+// Add the edges of E in order to the forest T, skipping edges that would close a cycle,
+// until T has treeSize edges. ds holds the trees of T
+void takeEdges(std::span<const Edge> E, DSets &ds, SpanningTree &T, int treeSize) {
+    for (auto const &e : E) {
+        if (std::ssize(T.edges) == treeSize) return;
+
+        const int r = ds.find(e.from);
+        const int s = ds.find(e.to);
+        if (r != s) {
+            ds.join(r, s);
+            T.edges.push_back(e);
+            T.weight += e.weight;
+        }
+    }
+}
+
+// Filter-Kruskal: E is split by the weight of a random pivot edge like in quicksort. The lighter edges are
+// handled first, then the heavier edges inside one tree of T are filtered out before they are sorted.
+// On graphs with many more edges than vertices most heavy edges are never sorted
+void filterKruskal(std::span<Edge> E, DSets &ds, SpanningTree &T, int treeSize, std::minstd_rand &random) {
+    if (E.empty() || std::ssize(T.edges) == treeSize) return;
+
+    if (E.size() <= filter_kruskal_min_edges) {
+        sortByWeight(E);
+        takeEdges(E, ds, T, treeSize);
+        return;
+    }
+
+    const int pivot = E[random() % E.size()].weight;
+    const auto lighter = std::partition(E.begin(), E.end(), [pivot](const Edge &e) { return e.weight < pivot; });
+    const auto heavier = std::partition(lighter, E.end(), [pivot](const Edge &e) { return e.weight == pivot; });
+
+    filterKruskal({E.begin(), lighter}, ds, T, treeSize, random);
+    takeEdges({lighter, heavier}, ds, T, treeSize);  // all of the same weight, no need to sort
+
+    // Keep only the heavier edges between two trees
+    const auto kept = std::partition(heavier, E.end(), [&ds](const Edge &e) {
+        return ds.find(e.from) != ds.find(e.to);
+    });
+    filterKruskal({heavier, kept}, ds, T, treeSize, random);
+}
+
+// number of threads to use, 0 threads is all hardware threads
+unsigned workerCount(unsigned threads) {
+    return (threads == 0) ? std::max(1u, std::thread::hardware_concurrency()) : threads;
+}
+
+// Runs work(k) for k = 0, ..., threads - 1, each on its own thread
+template <typename Work>
+void onThreads(unsigned threads, Work work) {
+    std::vector<std::jthread> pool;
+    for (unsigned k = 1; k < threads; ++k) {
+        pool.emplace_back(work, k);
+    }
+    work(0u);
+}  // the pool joins here
+
+// the part [begin, end) of 0..count - 1 that thread k of threads handles
+std::pair<std::size_t, std::size_t> share(std::size_t count, unsigned k, unsigned threads) {
+    return {count * k / threads, count * (k + 1) / threads};
+}
+
+// lower a to value, if value is smaller
+void lowerTo(std::atomic<std::uint64_t> &a, std::uint64_t value) {
+    std::uint64_t old = a.load(std::memory_order_relaxed);
+    while (value < old && !a.compare_exchange_weak(old, value, std::memory_order_relaxed)) {
+    }
+}
+
+}  // namespace
+
 // -- CONSTRUCTORS
 
 // Create a graph with n vertices and no vertices
@@ -22,25 +217,63 @@ Graph::Graph(int n) : table(n + 1), size{n}, n_edges{0} {
     assert(n >= 1);
 }
 
-Graph::Graph(const std::vector<Edge> &V, int n) : Graph{n} {
-    for (auto e : V) {
-        insertEdge(e);
+Graph::Graph(const std::vector<Edge> &V, int n, bool useEdgeIndex) : Graph{n} {
+    use_edge_index = useEdgeIndex;
+
+    // Both directions, in the order insertEdge would add them
+    std::vector<Edge> directed;
+    directed.reserve(2 * V.size());
+    for (auto const &e : V) {
+        directed.push_back(e);
+        directed.push_back(e.reverse());
+    }
+
+    // Repeated edges are removed up front, so that no edge has to be searched for
+    for (auto const &e : uniqueEdges(directed)) {
+        assert(e.from >= 1 && e.from <= size);
+        assert(e.to >= 1 && e.to <= size);
+
+        table[e.from].push_back(e);
+        if (use_edge_index) edge_index.emplace(edgeKey(e.from, e.to), std::prev(end(table[e.from])));
+        ++n_edges;
     }
 }
 
+// Create a graph with the given adjacency, which holds both directions of every edge
+Graph::Graph(CSR G, bool useEdgeIndex) : Graph{static_cast<int>(G.offsets.size()) - 2} {
+    use_edge_index = useEdgeIndex;
+    has_table = false;
+    n_edges = G.edges();
+    csr = std::move(G);
+    csr_dirty = false;
+}
+
 // -- MEMBER FUNCTIONS
 
+// fill table from csr, if the graph was created from an adjacency
+void Graph::buildTable() {
+    if (has_table) return;
+
+    for (int v = 1; v <= size; ++v) {
+        for (int i = csr.first(v); i < csr.last(v); ++i) {
+            table[v].push_back({v, csr.targets[i], csr.weights[i]});
+            if (use_edge_index) edge_index.emplace(edgeKey(v, csr.targets[i]), std::prev(end(table[v])));
+        }
+    }
+    has_table = true;
+}
+
 // insert undirected edge e
 // update weight if edge e is present
 void Graph::insertEdge(const Edge &e) {
     assert(e.from >= 1 && e.from <= size);
     assert(e.to >= 1 && e.to <= size);
+    buildTable();
 
-    auto edge_insertion = [&T = this->table, &n = this->n_edges](const Edge &e1) {
-        if (auto it = std::find_if(begin(T[e1.from]), end(T[e1.from]),
-                                   [e1](const Edge &ed) { return e1.links_same_nodes(ed); });
-            it == end(T[e1.from])) {
+    auto edge_insertion = [this, &T = this->table, &n = this->n_edges](const Edge &e1) {
+        if (auto it = findEdge(e1.from, e1.to); it == end(T[e1.from])) {
             T[e1.from].push_back(e1);  // insert new edge e1
+            if (use_edge_index) edge_index.emplace(edgeKey(e1.from, e1.to), std::prev(end(T[e1.from])));
             ++n;                       // increment the counter of edges
         } else {
             it->weight = e1.weight;  // update the weight
@@ -49,32 +282,67 @@ void Graph::insertEdge(const Edge &e) {
 
     edge_insertion(e);
     edge_insertion(e.reverse());
+    csr_dirty = true;
 }
 
 // remove undirected edge e
 void Graph::removeEdge(const Edge &e) {
     assert(e.from >= 1 && e.from <= size);
     assert(e.to >= 1 && e.to <= size);
+    buildTable();
 
-    auto edgeRemoval = [&T = this->table, &n = this->n_edges](const Edge &e1) {
-        auto it = std::find_if(begin(T[e1.from]), end(T[e1.from]),
-                               [e1](const Edge &ed) { return e1.links_same_nodes(ed); });
+    auto edgeRemoval = [this, &T = this->table, &n = this->n_edges](const Edge &e1) {
+        auto it = findEdge(e1.from, e1.to);
 
         assert(it != end(T[e1.from]));
+        if (use_edge_index) edge_index.erase(edgeKey(e1.from, e1.to));
         T[e1.from].erase(it);  // remove edge e1
         --n;                   // decrement the counter of edges
     };
 
     edgeRemoval(e);
     edgeRemoval(e.reverse());
+    csr_dirty = true;
+}
+
+// edge (u, v) in table[u], or end(table[u]) if there is no such edge
+std::list<Edge>::iterator Graph::findEdge(int u, int v) {
+    if (use_edge_index) {
+        auto it = edge_index.find(edgeKey(u, v));
+        return (it == edge_index.end()) ? end(table[u]) : it->second;
+    }
+    return std::find_if(begin(table[u]), end(table[u]), [v](const Edge &ed) { return ed.to == v; });
+}
+
+// flat copy of table used by the algorithms, rebuilt after the graph was modified
+const CSR &Graph::adjacency() const {
+    if (csr_dirty) {
+        csr = CSR{table};
+        csr_dirty = false;
+    }
+    return csr;
 }
 
 // Prim's minimum spanning tree algorithm
-void Graph::mstPrim() const {
+SpanningTree Graph::mstPrim(PrimMethod method) const {
+    if (method == PrimMethod::Automatic) {
+        // Both look at every edge once. Dense also scans the vertices not in the tree for every vertex added,
+        // Heap only pays O(log V) when an edge lowers the distance of a vertex, which few edges do.
+        // So Dense only wins when nearly all pairs of vertices are joined
+        const int degree = n_edges / size;  // average degree, n_edges counts both directions
+        method = (2 * degree >= size) ? PrimMethod::Dense : PrimMethod::Heap;
+    }
+    return (method == PrimMethod::Dense) ? mstPrimDense() : mstPrimHeap();
+}
+
+// Prim's algorithm, the next vertex is found by scanning all vertices not in the tree
+SpanningTree Graph::mstPrimDense() const {
     std::vector<int> dist(size + 1, std::numeric_limits<int>::max());
     std::vector<int> path(size + 1, 0);
     std::vector<bool> done(size + 1, false);
 
+    const CSR &G = adjacency();
+
     // *** TODO ***
 
     // Initalize the start node, in this case it's v1.
@@ -82,16 +350,20 @@ void Graph::mstPrim() const {
     dist[v] = 0;
     done[v] = true;
 
-    // Initalize the total weight of the spanning tree
-    int totalWeight = 0;
+    SpanningTree T;
+    T.edges.reserve(size - 1);
+
+    // The vertices not in the tree, so that the scan gets shorter as the tree grows
+    std::vector<int> remaining(size - 1);
+    std::iota(remaining.begin(), remaining.end(), 2);
 
     while (true) {
-        for (auto& e : table[v]) {
-            int u = e.to;
+        for (int i = G.first(v); i < G.last(v); ++i) {
+            int u = G.targets[i];
 
-            if (done[u] == false && dist[u] > e.weight) {
+            if (done[u] == false && dist[u] > G.weights[i]) {
                 
-                dist[u] = e.weight;
+                dist[u] = G.weights[i];
                 path[u] = v;
             }
         }
@@ -99,54 +371,125 @@ void Graph::mstPrim() const {
         // Find smallest undone distance vertex by checking every edge.
         // If only adjacent edges are checked we lose possible smaller edges
         // which would'nt result in a minimum spanning tree
+        // Of several closest vertices the smallest is chosen, as a scan of 1..size in order would
 
         int min = std::numeric_limits<int>::max();
+        std::size_t next = 0;
 
-        for (size_t u = 1; u <= size; u++) {
-            if (done[u] == false && dist[u] < min) {
+        for (std::size_t k = 0; k < remaining.size(); k++) {
+            const int u = remaining[k];
+            if (dist[u] < min || (dist[u] == min && u < v)) {
                 min = dist[u];
                 v = u;
+                next = k;
             }
         }
 
 
         if (min == std::numeric_limits<int>::max()) break;
         done[v] = true;
+        remaining[next] = remaining.back();
+        remaining.pop_back();
 
-        // Print current edge and it's weight
-        std::cout << "( " << path[v] << " ," << v << " ," << dist[v] << " )\n";
-        totalWeight += dist[v];
+        // Add current edge and it's weight
+        T.edges.push_back({path[v], v, dist[v]});
+        T.weight += dist[v];
     }
-    // Print the total weight of the minimum spanning tree
-    std::cout << "\n total weight = " << totalWeight << "\n";
-
+    return T;
 }
 
-// Kruskal's minimum spanning tree algorithm
-void Graph::mstKruskal() const {
-    // *** TODO ***
-    
-    std::vector<Edge> edgeVec;
-    edgeVec.reserve(size - 1);
+// Prim's algorithm, the vertices not in the tree are kept in a heap by their distance to the tree
+// Ties are broken as by mstPrimDense, so both find the same tree
+SpanningTree Graph::mstPrimHeap() const {
+    std::vector<int> dist(size + 1, std::numeric_limits<int>::max());
+    std::vector<int> path(size + 1, 0);
+    std::vector<bool> done(size + 1, false);
 
-    
-    // Compare each edge to one another and create a vector of the smallest edges
-    for (int v = 1; v <= size; v++) {
-        for (auto const& e : table[v]) {
-            if (e.from < e.to) {
-                edgeVec.push_back(e);
+    const CSR &G = adjacency();
+    IndexedHeap Q(size);
+
+    int v = 1;
+    dist[v] = 0;
+    done[v] = true;
+
+    SpanningTree T;
+    T.edges.reserve(size - 1);
+
+    while (true) {
+        for (int i = G.first(v); i < G.last(v); ++i) {
+            const int u = G.targets[i];
+            if (!done[u] && dist[u] > G.weights[i]) {
+                dist[u] = G.weights[i];
+                path[u] = v;
+                Q.push(u, dist[u]);
             }
         }
+
+        // The heap holds exactly the vertices not in the tree that have an edge to it
+        if (Q.empty()) break;
+        v = Q.pop();
+        done[v] = true;
+
+        T.edges.push_back({path[v], v, dist[v]});
+        T.weight += dist[v];
+    }
+    return T;
+}
+
+// Kruskal's minimum spanning tree algorithm
+SpanningTree Graph::mstKruskal(KruskalMethod method) const {
+    switch (method) {
+        case KruskalMethod::Heap:
+            return mstKruskalHeap();
+        case KruskalMethod::Filter:
+            return mstKruskalFilter();
+        default:
+            return mstKruskalSort();
     }
+}
+
+// Kruskal's algorithm, the edges are sorted once and then taken in order
+SpanningTree Graph::mstKruskalSort() const {
+    std::vector<Edge> edgeVec = undirectedEdges();
+    sortByWeight(edgeVec);
+
+    DSets ds(size);
+    SpanningTree T;
+    T.edges.reserve(size - 1);
+
+    // A spanning tree has size - 1 edges, the rest of the edges need not be looked at
+    takeEdges(edgeVec, ds, T, size - 1);
+    return T;
+}
+
+// Kruskal's algorithm, the edges are split by weight and filtered before they are sorted
+SpanningTree Graph::mstKruskalFilter() const {
+    std::vector<Edge> edgeVec = undirectedEdges();
+
+    DSets ds(size);
+    SpanningTree T;
+    T.edges.reserve(size - 1);
+
+    std::minstd_rand random;  // default seed, the pivots are the same on every run
+    filterKruskal(edgeVec, ds, T, size - 1, random);
+    return T;
+}
+
+// Kruskal's algorithm, the edges are taken from a heap, which only orders the edges that are looked at
+SpanningTree Graph::mstKruskalHeap() const {
+    // *** TODO ***
+    
+    std::vector<Edge> edgeVec = undirectedEdges();
 
     DSets ds(size);
     // Create min_heap from the vector of edges
     std::ranges::make_heap(edgeVec, std::greater<Edge>{});
 
-    int totalWeight = 0;
-    int counter = 0;
+    SpanningTree T;
+    T.edges.reserve(size - 1);
 
-    while (counter < size - 1) {
+    // The heap runs out before size - 1 edges are found if the graph is not connected
+    while (std::ssize(T.edges) < size - 1 && !edgeVec.empty()) {
         // The smallest edge will be in the front of the min_heap, this edge is saved
         Edge smallestEdge = edgeVec.front();
         
@@ -161,12 +504,159 @@ void Graph::mstKruskal() const {
         // Perform union by size if from and to are diffrent verticies
         if (smallestEdgeFrom != smallestEdgeTo) {
             ds.join(smallestEdgeFrom, smallestEdgeTo);
-            std::cout << smallestEdge << "\n";
-            totalWeight += smallestEdge.weight;
-            counter++;
+            T.edges.push_back(smallestEdge);
+            T.weight += smallestEdge.weight;
         }
     }
-    std::cout << "\n total weight = " << totalWeight << "\n";
+    return T;
+}
+
+// Boruvka's minimum spanning tree algorithm
+SpanningTree Graph::mstBoruvka(unsigned threads) const {
+    const std::vector<Edge> E = undirectedEdges();
+    threads = (std::ssize(E) < parallel_min_edges) ? 1 : workerCount(threads);
+
+    // Every edge gets the key (weight, index in E), so that no two edges weigh the same and the lightest
+    // edges leaving the trees never close a cycle
+    const auto offset = E.empty() ? 0u : static_cast<unsigned>(std::ranges::min(E, {}, &Edge::weight).weight);
+    auto key = [&E, offset](int i) {
+        return (std::uint64_t{static_cast<unsigned>(E[i].weight) - offset} << 32) | static_cast<unsigned>(i);
+    };
+    constexpr std::uint64_t none = std::numeric_limits<std::uint64_t>::max();
+
+    std::vector<int> tree(size + 1);  // tree[v] is the root of the tree of v
+    std::iota(tree.begin(), tree.end(), 0);
+    std::vector<int> roots(size);  // roots of the trees that may still have edges leaving them
+    std::iota(roots.begin(), roots.end(), 1);
+    std::vector<std::atomic<std::uint64_t>> lightest(size + 1);  // key of the lightest edge leaving every tree
+    for (auto &k : lightest) {
+        k.store(none, std::memory_order_relaxed);
+    }
+
+    // The edges between two trees, thread k keeps the ones of its share of E at the start of that share
+    std::vector<int> edges(E.size());
+    std::iota(edges.begin(), edges.end(), 0);
+    std::vector<std::size_t> kept(threads);
+    for (unsigned k = 0; k < threads; ++k) {
+        const auto [begin, end] = share(E.size(), k, threads);
+        kept[k] = end - begin;
+    }
+
+    // hook[r] is the tree the lightest edge of tree r leads to, parent[r] the tree r is joined to, both only
+    // for the roots r of the trees
+    std::vector<int> hook(size + 1, 0);
+    std::vector<int> parent(size + 1, 0);
+    std::vector<int> jumped(size + 1, 0);
+
+    SpanningTree T;
+    T.edges.reserve(size - 1);
+
+    while (true) {
+        // Find the lightest edge leaving every tree and drop the edges inside a tree
+        onThreads(threads, [&](unsigned k) {
+            const std::size_t begin = share(E.size(), k, threads).first;
+            std::size_t count = 0;
+            for (std::size_t j = begin; j < begin + kept[k]; ++j) {
+                const int i = edges[j];
+                const int r = tree[E[i].from];
+                const int s = tree[E[i].to];
+                if (r == s) continue;
+
+                edges[begin + count++] = i;
+                lowerTo(lightest[r], key(i));
+                lowerTo(lightest[s], key(i));
+            }
+            kept[k] = count;
+        });
+
+        // Every tree hooks onto the tree at the other end of its lightest edge
+        // The hooks form trees with one cycle each, an edge that is the lightest of both its trees. The tree of
+        // the larger root of such an edge is the root of the joined trees, the other tree takes the edge
+        std::vector<int> taken(roots.size(), -1);  // index in E of the edge taken by every tree
+        onThreads(threads, [&](unsigned k) {
+            const auto [begin, end] = share(roots.size(), k, threads);
+            for (std::size_t j = begin; j < end; ++j) {
+                const int r = roots[j];
+                const std::uint64_t lightest_key = lightest[r].exchange(none, std::memory_order_relaxed);
+                if (lightest_key == none) {
+                    hook[r] = r;
+                    continue;
+                }
+
+                taken[j] = static_cast<int>(lightest_key & 0xFFFFFFFF);
+                const Edge &e = E[taken[j]];
+                hook[r] = (tree[e.from] == r) ? tree[e.to] : tree[e.from];
+            }
+        });
+        onThreads(threads, [&](unsigned k) {
+            const auto [begin, end] = share(roots.size(), k, threads);
+            for (std::size_t j = begin; j < end; ++j) {
+                const int r = roots[j];
+                const bool top = (hook[hook[r]] == r && r > hook[r]);
+                parent[r] = top ? r : hook[r];
+                if (top) taken[j] = -1;
+            }
+        });
+
+        bool joined = false;
+        for (int i : taken) {
+            if (i < 0) continue;
+            T.edges.push_back(E[i]);
+            T.weight += E[i].weight;
+            joined = true;
+        }
+        if (!joined) break;
+
+        // Pointer jumping: every tree follows parent to the root of its joined trees in log V steps
+        bool moved = true;
+        while (moved) {
+            std::vector<char> moves(threads, 0);
+            onThreads(threads, [&](unsigned k) {
+                const auto [begin, end] = share(roots.size(), k, threads);
+                for (std::size_t j = begin; j < end; ++j) {
+                    const int r = roots[j];
+                    jumped[r] = parent[parent[r]];
+                    moves[k] |= (jumped[r] != parent[r]);
+                }
+            });
+            std::swap(parent, jumped);
+            moved = std::ranges::any_of(moves, [](char m) { return m != 0; });
+        }
+
+        // Every vertex learns the root of its tree
+        onThreads(threads, [&](unsigned k) {
+            const auto [begin, end] = share(tree.size(), k, threads);
+            for (std::size_t v = begin; v < end; ++v) {
+                tree[v] = parent[tree[v]];
+            }
+        });
+        std::erase_if(roots, [&parent](int r) { return parent[r] != r; });
+    }
+    return T;
+}
+
+// the edges (u, v) with u < v, one for every undirected edge
+std::vector<Edge> Graph::undirectedEdges() const {
+    const CSR &G = adjacency();
+
+    std::vector<Edge> E;
+    E.reserve(G.edges() / 2);
+    for (int v = 1; v <= size; v++) {
+        for (int i = G.first(v); i < G.last(v); ++i) {
+            if (v < G.targets[i]) {
+                E.push_back({v, G.targets[i], G.weights[i]});
+            }
+        }
+    }
+    return E;
+}
+
+// print the edges and the total weight of a spanning tree
+void printTree(const SpanningTree& T) {
+    for (auto const &e : T.edges) {
+        std::cout << e << "\n";
+    }
+    std::cout << "\n total weight = " << T.weight << "\n";
 }
 
 // print graph
@@ -175,10 +665,12 @@ void Graph::printGraph() const {
     std::cout << "Vertex  adjacency lists\n";
     std::cout << std::format("{:-<66}\n", '-');
 
+    // The adjacency holds the edges of every vertex in the order of its list
+    const CSR &G = adjacency();
     for (int v = 1; v <= size; v++) {
         std::cout << std::format("{:4} : ", v);
-        for (auto const &e : table[v]) {
-            std::cout << std::format("({:2}, {:2}) ", e.to, e.weight);
+        for (int i = G.first(v); i < G.last(v); ++i) {
+            std::cout << std::format("({:2}, {:2}) ", G.targets[i], G.weights[i]);
         }
         std::cout << "\n";
     }
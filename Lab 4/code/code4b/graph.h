@@ -7,15 +7,29 @@
 
 #include <vector>
 #include <list>
+#include <unordered_map>
 
 #include "edge.h"
+#include "csr.h"
+
+// Minimum spanning tree found by mstPrim or mstKruskal
+struct SpanningTree {
+    std::vector<Edge> edges;  // the edges of the tree, in the order they were chosen
+    long long weight{0};      // total weight of the edges
+};
 
 class Graph {
 public:
     // -- CONSTRUCTOR
    
     // Create a graph with n vertices and the edges in V
-    Graph(const std::vector<Edge>& V, int n);
+    // With useEdgeIndex, insertEdge and removeEdge find an edge in O(1) instead of O(degree)
+    Graph(const std::vector<Edge>& V, int n, bool useEdgeIndex = false);
+
+    // Create a graph with the given adjacency, which holds both directions of every edge,
+    // e.g. a mapped binary graph file (see graphfile.h)
+    // The algorithms use G as it is, the adjacency lists are only built when the graph is modified
+    explicit Graph(CSR G, bool useEdgeIndex = false);
 
     // Disallow copying
     Graph(const Graph &) = delete;
@@ -23,6 +37,16 @@ public:
 
     // -- MEMBER FUNCTIONS
 
+    // number of vertices
+    int vertices() const {
+        return size;
+    }
+
+    // number of edges, (u, v) and (v, u) are one edge
+    int edges() const {
+        return n_edges / 2;
+    }
+
     // insert undirected edge (u, v) with weight w
     // update weight w if edge (u, v) is present
     void insertEdge(const Edge& e);
@@ -30,11 +54,33 @@ public:
     // remove undirected edge e
     void removeEdge(const Edge& e);
 
+    // Versions of Prim's algorithm, see mstPrim
+    enum class PrimMethod { Automatic, Dense, Heap };
+
     // Prim's minimum spanning tree algorithm
-    void mstPrim() const;
+    // Dense finds the next vertex by scanning all vertices not in the tree, O(V^2), which suits nearly
+    // complete graphs. Heap keeps them in an indexed heap, O(E log V), which suits sparse graphs
+    // Automatic chooses from the average degree E/V, both versions find the same tree
+    SpanningTree mstPrim(PrimMethod method = PrimMethod::Automatic) const;
+
+    // Versions of Kruskal's algorithm, see mstKruskal
+    enum class KruskalMethod { Sort, Heap, Filter };
 
     // Kruskal's minimum spanning tree algorithm
-    void mstKruskal() const;
+    // Sort radix sorts all edges by weight, O(E), and stops as soon as the tree is complete
+    // Heap builds a heap of the edges in O(E) and pays O(log E) for every edge taken from it, which is faster
+    // when the tree is complete after few of the edges
+    // Filter is Filter-Kruskal: the edges are split by weight as in quicksort and the heavier part is only
+    // sorted after the edges inside one tree were dropped from it
+    // If the graph is not connected, the result is a minimum spanning forest
+    SpanningTree mstKruskal(KruskalMethod method = KruskalMethod::Sort) const;
+
+    // Boruvka's minimum spanning tree algorithm, in parallel on the given number of threads
+    // 0 threads uses all hardware threads. Every round joins each tree with the tree at the other end of
+    // its lightest edge, so there are at most log V rounds. Finding the edges, joining the trees by pointer
+    // jumping and relabelling the vertices run on all threads, only appending the new edges to the tree does not
+    // If the graph is not connected, the result is a minimum spanning forest
+    SpanningTree mstBoruvka(unsigned threads = 0) const;
 
     // print graph
     void printGraph() const;
@@ -43,8 +89,46 @@ private:
     // -- Private CONSTRUCTOR
     explicit Graph(int n);  // Create a graph with n vertices and no vertices
 
+    // flat copy of table used by the algorithms, rebuilt after the graph was modified
+    const CSR& adjacency() const;
+
+    // fill table from csr, if the graph was created from an adjacency
+    void buildTable();
+
+    // the two versions of Prim's algorithm
+    SpanningTree mstPrimDense() const;
+    SpanningTree mstPrimHeap() const;
+
+    // the versions of Kruskal's algorithm
+    SpanningTree mstKruskalSort() const;
+    SpanningTree mstKruskalHeap() const;
+    SpanningTree mstKruskalFilter() const;
+
+    // the edges (u, v) with u < v, one for every undirected edge
+    std::vector<Edge> undirectedEdges() const;
+
+    // edge (u, v) in table[u], or end(table[u]) if there is no such edge
+    std::list<Edge>::iterator findEdge(int u, int v);
+
+    // key of edge (u, v) in edge_index
+    long long edgeKey(int u, int v) const {
+        return static_cast<long long>(u) * (size + 1) + v;
+    }
+
     // -- DATA MEMBERS
     std::vector<std::list<Edge>> table;  // table of adjacency lists
+    bool has_table{true};                // false until buildTable() is called for a graph made from a CSR
     int size;                            // number of vertices
     int n_edges;                         // number of edges
+
+    // insertEdge and removeEdge only modify table and mark csr as outdated
+    mutable CSR csr;
+    mutable bool csr_dirty{true};
+
+    // optional index of both directions of all edges: (u, v) -> position in table[u]
+    bool use_edge_index{false};
+    std::unordered_map<long long, std::list<Edge>::iterator> edge_index;
 };
+
+// print the edges and the total weight of a spanning tree
+void printTree(const SpanningTree& T);
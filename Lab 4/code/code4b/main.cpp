@@ -6,11 +6,39 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <string_view>
 #include <cstdlib>  // std::atoi
 #include <vector>
 #include <memory>  // std::unique_ptr
+#include <stdexcept>
+#include <utility>  // std::pair
+#include <filesystem>
+#include <chrono>
+#include <sstream>
+#include <format>
 
 #include "graph.h"
+#include "graphfile.h"
+
+/*
+ * Without arguments the program shows the menu. With arguments it runs a batch of commands on one graph
+ * and prints a JSON object per line, for scripts and benchmarks:
+ *
+ *   Lab4b [--verify] <graph file> [-f <command file>] [<command>...]
+ *     --verify  check every edge of a binary graph file (.csr), see verifyGraphFile. Without it the edges are
+ *               used unchecked, so unverified files must come from Lab4Convert or pass Lab4Convert --verify
+ *     -f        read commands from a file, separated by white space, # starts a comment
+ *
+ *   commands: mstPrim, mstPrimDense, mstPrimHeap, mstKruskal, mstKruskalHeap, mstKruskalFilter, mstBoruvka
+ *   mstPrim chooses between the dense and the heap version of Prim's algorithm, the others force one
+ *   mstKruskal sorts the edges, mstKruskalHeap takes them from a heap, mstKruskalFilter is Filter-Kruskal
+ *   mstBoruvka runs on all hardware threads
+ *
+ * The graph file is opened as given, not relative to ../code/code4b/. The first line describes the
+ * loaded graph, every command adds a line with the total weight and the number of edges of the tree and
+ * the time it took in ms, e.g.
+ *   {"command":"mstPrim","weight":16,"edges":6,"ms":0.012}
+ */
 
 // -- FUNCTION DECLARATIONS
 
@@ -22,9 +50,19 @@ int menu();
 // Return a pointer to the graph
 std::unique_ptr<Graph> readGraph(const std::string& fileName);
 
+// Read a text graph file or map a binary graph file (see graphfile.h) and create the graph
+// The edges of a binary graph file are only checked if verify is set
+// throws std::runtime_error if the file can not be read
+std::unique_ptr<Graph> loadGraph(const std::filesystem::path& file, bool verify = false);
+
+// run the commands given by the program arguments, see above
+int runCommands(const std::vector<std::string_view>& args);
+
 // -- MAIN PROGRAM
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1) return runCommands({argv + 1, argv + argc});
+
     int choice{0};
     std::string fileName{};
 
@@ -40,11 +78,11 @@ int main() {
                 break;
             case 2:
                 std::cout << "\n";
-                if (G) G->mstPrim();
+                if (G) printTree(G->mstPrim());
                 break;
             case 3:
                 std::cout << "\n";
-                if (G) G->mstKruskal();
+                if (G) printTree(G->mstKruskal());
                 break;
             case 4:
                 std::cout << "\n";
@@ -86,25 +124,156 @@ int menu() {
 // Read a graph's data from a file and create the graph
 // Return a pointer to the graph
 std::unique_ptr<Graph> readGraph(const std::string& fileName) {
-    std::ifstream file{"../code/code4b/" + fileName};  // modify the file path, if needed (Mac)
-
-    if (!file) {
-        std::cout << "File not found!\n";
+    try {
+        return loadGraph("../code/code4b/" + fileName, true);  // modify the file path, if needed (Mac)
+    } catch (const std::runtime_error& e) {
+        std::cout << e.what() << "\n";
         return nullptr;
     }
+}
+
+// Read a text graph file or map a binary graph file and create the graph
+std::unique_ptr<Graph> loadGraph(const std::filesystem::path& file, bool verify) {
+    // Binary graph files, see graphfile.h, are mapped instead of read
+    if (file.extension() == ".csr") {
+        return std::unique_ptr<Graph>{new Graph{verify ? verifyGraphFile(file) : mapGraphFile(file)}};
+    }
+
+    std::ifstream in{file};
+
+    if (!in) {
+        throw std::runtime_error(std::format("File {} not found!", file.string()));
+    }
 
     int n{0};
-    file >> n;  // read number of vertices
+    in >> n;  // read number of vertices
+    if (n < 1) throw std::runtime_error(std::format("{} is not a graph file", file.string()));
 
-    std::vector<Edge> E{};  // to store the edges
+    std::vector<Edge> E{};  // to store both directions of the edges
     int u{0};
     int v{0};
     int w{0};
 
     // Read all edges
-    while (file >> u >> v >> w) {
+    while (in >> u >> v >> w) {
         // cout << u << " " << " " << w << "\n";
         E.push_back({u, v, w});
+        E.push_back({v, u, w});
+    }
+
+    // The adjacency is built here rather than by the first algorithm, so that the algorithms can be timed
+    return std::unique_ptr<Graph>{new Graph{fileAdjacency(E, n)}};
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Append the words of a command file, # starts a comment
+void readCommandFile(const std::string& file, std::vector<std::string>& words) {
+    std::ifstream in{file};
+    if (!in) throw std::runtime_error(std::format("File {} not found!", file));
+
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream words_of_line{line.substr(0, line.find('#'))};
+        for (std::string word; words_of_line >> word;) {
+            words.push_back(word);
+        }
+    }
+}
+
+// text as a JSON string
+std::string json(std::string_view text) {
+    std::string result{"\""};
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            result += std::format("\\u{:04x}", c);
+        } else {
+            result += c;
+        }
+    }
+    return result + "\"";
+}
+
+// The commands and the algorithms they run
+using Algorithm = SpanningTree (*)(const Graph&);
+
+const std::pair<std::string_view, Algorithm> algorithms[] = {
+    {"mstPrim", [](const Graph& G) { return G.mstPrim(); }},
+    {"mstPrimDense", [](const Graph& G) { return G.mstPrim(Graph::PrimMethod::Dense); }},
+    {"mstPrimHeap", [](const Graph& G) { return G.mstPrim(Graph::PrimMethod::Heap); }},
+    {"mstKruskal", [](const Graph& G) { return G.mstKruskal(); }},
+    {"mstKruskalHeap", [](const Graph& G) { return G.mstKruskal(Graph::KruskalMethod::Heap); }},
+    {"mstKruskalFilter", [](const Graph& G) { return G.mstKruskal(Graph::KruskalMethod::Filter); }},
+    {"mstBoruvka", [](const Graph& G) { return G.mstBoruvka(); }},
+};
+
+// the algorithm of a command, nullptr for an unknown command
+Algorithm findAlgorithm(std::string_view command) {
+    for (auto const& [name, algorithm] : algorithms) {
+        if (name == command) return algorithm;
+    }
+    return nullptr;
+}
+
+// Run one command on G and return its JSON object
+std::string runCommand(const Graph& G, const std::string& command) {
+    const auto start = Clock::now();
+    const SpanningTree T = findAlgorithm(command)(G);
+    const double ms = millisecondsSince(start);
+
+    return std::format("{{\"command\":{},\"weight\":{},\"edges\":{},\"ms\":{:.3f}}}", json(command), T.weight,
+                       T.edges.size(), ms);
+}
+
+}  // namespace
+
+// run the commands given by the program arguments
+int runCommands(const std::vector<std::string_view>& args) try {
+    bool verify = false;
+    std::string graphFile;
+    std::vector<std::string> commands;
+
+    for (std::size_t i = 0; i < args.size(); ++i) {
+        if (args[i] == "--verify") {
+            verify = true;
+        } else if (args[i] == "-f" && i + 1 < args.size()) {
+            readCommandFile(std::string{args[++i]}, commands);
+        } else if (graphFile.empty()) {
+            graphFile = args[i];
+        } else {
+            commands.emplace_back(args[i]);
+        }
+    }
+    if (graphFile.empty()) {
+        throw std::runtime_error("Usage: Lab4b [--verify] <graph file> [-f <command file>] [<command>...]");
+    }
+
+    // All commands are checked before the graph is read
+    for (auto const& command : commands) {
+        if (!findAlgorithm(command)) {
+            throw std::runtime_error(std::format("unknown command {}", command));
+        }
+    }
+
+    const auto start = Clock::now();
+    const std::unique_ptr<Graph> G = loadGraph(graphFile, verify);
+    std::cout << std::format("{{\"command\":\"load\",\"file\":{},\"vertices\":{},\"edges\":{},\"ms\":{:.3f}}}\n",
+                             json(graphFile), G->vertices(), G->edges(), millisecondsSince(start));
+
+    for (auto const& command : commands) {
+        std::cout << runCommand(*G, command) << "\n";
     }
-    return std::unique_ptr<Graph>{new Graph{E, n}};
+    return 0;
+} catch (const std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return 1;
 }